@@ -0,0 +1,84 @@
+#ifndef AGENT_STORE_H
+#define AGENT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+// Agent positions and velocities on the ground plane as separate float arrays (structure of arrays)
+// Arrays are 32 byte aligned and followed by LANES floats of slack, so SIMD kernels can load a full register
+// starting at any index below size()
+class AgentStore
+{
+public:
+	enum : unsigned int { ALIGN = 32, LANES = 8 };
+
+	float *x = nullptr;
+	float *z = nullptr;
+	float *vx = nullptr;
+	float *vz = nullptr;
+
+	AgentStore() {}
+	~AgentStore() { release(); }
+
+	AgentStore(const AgentStore &) = delete;
+	AgentStore &operator=(const AgentStore &) = delete;
+
+	unsigned int size() const { return count; }
+
+	// Grow to n agents, keeping existing values and zeroing new ones
+	void resize(unsigned int n)
+	{
+		if (n > capacity)
+		{
+			unsigned int newCapacity = capacity > 0 ? capacity : LANES;
+			while (newCapacity < n)
+				newCapacity *= 2;
+
+			unsigned int stride = newCapacity + LANES;
+			void *newRaw = ::operator new(sizeof(float) * stride * 4 + ALIGN);
+			float *block = (float *)(((std::uintptr_t)newRaw + ALIGN - 1) & ~(std::uintptr_t)(ALIGN - 1));
+			std::memset(block, 0, sizeof(float) * stride * 4);
+			if (count > 0)
+			{
+				std::memcpy(block, x, sizeof(float) * count);
+				std::memcpy(block + stride, z, sizeof(float) * count);
+				std::memcpy(block + stride * 2, vx, sizeof(float) * count);
+				std::memcpy(block + stride * 3, vz, sizeof(float) * count);
+			}
+			release();
+			raw = newRaw;
+			capacity = newCapacity;
+			x = block;
+			z = block + stride;
+			vx = block + stride * 2;
+			vz = block + stride * 3;
+		}
+		count = n;
+	}
+
+	void push_back(float px, float pz, float pvx, float pvz)
+	{
+		resize(count + 1);
+		x[count - 1] = px;
+		z[count - 1] = pz;
+		vx[count - 1] = pvx;
+		vz[count - 1] = pvz;
+	}
+
+private:
+	void *raw = nullptr; // One allocation holding all four arrays
+	unsigned int count = 0;
+	unsigned int capacity = 0; // Always a multiple of LANES
+
+	void release()
+	{
+		if (raw)
+			::operator delete(raw);
+		raw = nullptr;
+		x = z = vx = vz = nullptr;
+	}
+};
+
+#endif
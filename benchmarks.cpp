@@ -0,0 +1,402 @@
+// Micro/macro benchmarks for the planner hot paths
+// Usage: benchmarks [--filter text] [--min-time seconds]
+// Each case is run repeatedly until it has taken at least min-time, then reports time per op, throughput and
+// heap allocations per op in the same spirit as Google Benchmark's console output
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "planner.h"
+#include "scenario.h"
+
+using namespace std;
+
+// Allocation counting ----------------------
+
+static atomic<unsigned long long> allocCount(0);
+
+void *operator new(size_t size)
+{
+	allocCount++;
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+// Harness ----------------------------------
+
+struct BenchmarkState
+{
+	unsigned long long iterations = 0;
+	unsigned long long itemsPerIteration = 1; // Set by the case, eg agents per step
+};
+
+struct Benchmark
+{
+	string name;
+	function<void(BenchmarkState &)> setupAndRun; // Runs state.iterations ops
+};
+
+vector<Benchmark> &registry()
+{
+	static vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+void addBenchmark(const string &name, function<void(BenchmarkState &)> f)
+{
+	Benchmark b;
+	b.name = name;
+	b.setupAndRun = f;
+	registry().push_back(b);
+}
+
+// Each case times only the loop it reports, setup is excluded
+struct Timer
+{
+	chrono::steady_clock::time_point start;
+	unsigned long long allocStart;
+	double seconds = 0.0;
+	unsigned long long allocs = 0;
+
+	void begin()
+	{
+		allocStart = allocCount;
+		start = chrono::steady_clock::now();
+	}
+
+	void end()
+	{
+		seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		allocs += allocCount - allocStart;
+	}
+};
+
+static Timer *currentTimer = nullptr;
+static volatile unsigned int sink; // Keeps results alive so loops aren't optimised away
+
+void runBenchmark(const Benchmark &b, double minTime)
+{
+	BenchmarkState state;
+	Timer timer;
+	unsigned long long iterations = 1;
+	while (true)
+	{
+		timer = Timer();
+		currentTimer = &timer;
+		state.iterations = iterations;
+		b.setupAndRun(state);
+		if (timer.seconds >= minTime || iterations >= 1000000000ull)
+			break;
+		// Aim a bit past minTime next round
+		double scale = timer.seconds > 0.0 ? 1.4 * minTime / timer.seconds : 10.0;
+		iterations = (unsigned long long)(iterations * min(max(scale, 1.5), 100.0)) + 1;
+	}
+
+	double nsPerOp = timer.seconds * 1e9 / iterations;
+	double itemsPerSec = iterations * state.itemsPerIteration / timer.seconds;
+	double allocsPerOp = (double)timer.allocs / iterations;
+	printf("%-48s %14.0f ns %12llu %14.4g items/s %10.1f allocs/op\n", b.name.c_str(), nsPerOp, iterations, itemsPerSec, allocsPerOp);
+}
+
+// Scenario helpers -------------------------
+
+// Random obstacles over a map sized to fit them, no agents
+void setupObstacles(MotionPlanner &planner, int numBarrels, int numCars)
+{
+	srand(1);
+	planner.mapSize = 40.0f * sqrt(max(1.0f, (numBarrels + numCars) / 9.0f));
+	addRandomObstacles(planner, numBarrels, numCars);
+}
+
+// Benchmarks -------------------------------
+
+void registerBenchmarks()
+{
+	// Segment tests against a growing obstacle set, through the grid and the linear reference
+	int obstacleCounts[] = { 10, 100, 1000 };
+	for (int n : obstacleCounts)
+	{
+		for (int linear = 0; linear <= 1; linear++)
+		{
+			addBenchmark("collidesWithObs/barrels:" + to_string(n) + "/cars:" + to_string(n / 2) + (linear ? "/linear" : "/grid"), [n, linear](BenchmarkState &state)
+			{
+				MotionPlanner planner(1);
+				setupObstacles(planner, n, n / 2);
+				vector<glm::vec2> ends;
+				for (int i = 0; i < 1024; i++)
+				{
+					glm::vec3 p = randomFreePoint(planner);
+					ends.push_back(glm::vec2(p[0], p[2]));
+				}
+
+				unsigned int hits = 0;
+				currentTimer->begin();
+				for (unsigned long long i = 0; i < state.iterations; i++)
+				{
+					glm::vec2 p1 = ends[i & 1023], p2 = ends[(i * 7 + 1) & 1023];
+					hits += linear ? planner.obstacles.collidesWithObsLinear(p1, p2) : planner.obstacles.collidesWithObs(p1, p2);
+				}
+				currentTimer->end();
+				sink = hits;
+			});
+		}
+	}
+
+	// Full roadmap construction (sampling and connection) for the default obstacles
+	int sampleCounts[] = { 100, 200, 400 };
+	for (int n : sampleCounts)
+	{
+		addBenchmark("buildRoadmap/numNewPos:" + to_string(n), [n](BenchmarkState &state)
+		{
+			for (unsigned long long i = 0; i < state.iterations; i++)
+			{
+				MotionPlanner planner(1);
+				loadDefaultScenario(planner);
+				planner.numNewPos = n;
+				currentTimer->begin();
+				planner.buildRoadmap(1);
+				currentTimer->end();
+			}
+		});
+	}
+
+	// Neighbour based connection at sample counts where connecting every pair is out of reach
+	int largeSampleCounts[] = { 10000, 100000 };
+	for (int n : largeSampleCounts)
+	{
+		for (int strategy = CONNECT_K_NEAREST; strategy <= CONNECT_RADIUS; strategy++)
+		{
+			addBenchmark("buildRoadmap/numNewPos:" + to_string(n) + (strategy == CONNECT_K_NEAREST ? "/knn" : "/radius"), [n, strategy](BenchmarkState &state)
+			{
+				for (unsigned long long i = 0; i < state.iterations; i++)
+				{
+					MotionPlanner planner(1);
+					setupObstacles(planner, n / 25, n / 50);
+					planner.numNewPos = n;
+					planner.roadmap.connection = (ConnectionStrategy)strategy;
+					currentTimer->begin();
+					planner.buildRoadmap(1);
+					currentTimer->end();
+				}
+			});
+		}
+	}
+
+	// Roadmap construction plus planning a crowd over it, testing every edge up front or only those the paths use
+	for (int lazy = 1; lazy >= 0; lazy--)
+	{
+		addBenchmark(string("createRoadmap/agents:16/numNewPos:10000/knn") + (lazy ? "/lazy" : "/eager"), [lazy](BenchmarkState &state)
+		{
+			for (unsigned long long i = 0; i < state.iterations; i++)
+			{
+				MotionPlanner planner(1);
+				setupObstacles(planner, 400, 200);
+				addRandomCrowd(planner, 16);
+				planner.numNewPos = 10000;
+				planner.roadmap.connection = CONNECT_K_NEAREST;
+				planner.roadmap.lazy = lazy != 0;
+				planner.aStar = true;
+				currentTimer->begin();
+				planner.createRoadmap(1);
+				currentTimer->end();
+			}
+		});
+	}
+
+	// One search per op over a fixed roadmap, cycling through the agents
+	for (int useAStar = 1; useAStar >= 0; useAStar--)
+	{
+		addBenchmark(string(useAStar ? "findPath/A*" : "findPath/uniformCost") + "/numNewPos:400", [useAStar](BenchmarkState &state)
+		{
+			MotionPlanner planner(1);
+			srand(1);
+			loadDefaultScenario(planner);
+			addRandomCrowd(planner, 48);
+			planner.numNewPos = 400;
+			planner.buildRoadmap(1);
+
+			vector<unsigned int> path;
+			unsigned int numAgents = planner.crowd.numAgents();
+			currentTimer->begin();
+			for (unsigned long long i = 0; i < state.iterations; i++)
+			{
+				unsigned int agent = i % numAgents;
+				planner.roadmap.findPath(planner.startIndices[agent], planner.goalIndices[agent], useAStar != 0, path);
+			}
+			currentTimer->end();
+		});
+	}
+
+	// Batches of searches between random roadmap nodes spread over the pool, items are searches
+	addBenchmark("findPaths/queries:1000/numNewPos:2000", [](BenchmarkState &state)
+	{
+		MotionPlanner planner(0);
+		srand(1);
+		planner.mapSize = 80.0f;
+		addRandomObstacles(planner, 20, 10);
+		planner.numNewPos = 2000;
+		planner.roadmap.connection = CONNECT_K_NEAREST;
+		planner.buildRoadmap(1);
+
+		vector<PathQuery> queries(1000);
+		for (unsigned int q = 0; q < queries.size(); q++)
+		{
+			queries[q].start = rand() % planner.roadmap.numNodes();
+			queries[q].goal = rand() % planner.roadmap.numNodes();
+		}
+		vector<vector<unsigned int>> paths;
+		planner.roadmap.findPaths(queries, true, planner.pool, paths);
+
+		unsigned int found = 0;
+		state.itemsPerIteration = queries.size();
+		currentTimer->begin();
+		for (unsigned long long i = 0; i < state.iterations; i++)
+			found += planner.roadmap.findPaths(queries, true, planner.pool, paths);
+		currentTimer->end();
+		sink = found;
+	});
+
+	// Plan a crowd heading for a few exits, items are agents planned
+	for (int shared = 1; shared >= 0; shared--)
+	{
+		addBenchmark(string("planPaths/agents:1000/exits:4/numNewPos:2000") + (shared ? "/flowFields" : "/aStar"), [shared](BenchmarkState &state)
+		{
+			const int numAgents = 1000;
+			MotionPlanner planner(1);
+			srand(1);
+			planner.mapSize = 80.0f;
+			addRandomObstacles(planner, 20, 10);
+			addExitCrowd(planner, numAgents, 4);
+			planner.numNewPos = 2000;
+			planner.roadmap.connection = CONNECT_K_NEAREST;
+			planner.aStar = true;
+			planner.sharedGoals = shared != 0;
+			planner.buildRoadmap(1);
+
+			state.itemsPerIteration = numAgents;
+			currentTimer->begin();
+			for (unsigned long long i = 0; i < state.iterations; i++)
+				planner.planPaths();
+			currentTimer->end();
+		});
+	}
+
+	// Replan every agent after the crowd moves on a little and one obstacle is dropped on the map, items are agents
+	// replanned. Obstacles are added outside the timer, with a fresh map every 50 so the roadmap doesn't fill up
+	for (int incremental = 1; incremental >= 0; incremental--)
+	{
+		addBenchmark(string("replanAll/agents:200/numNewPos:2000") + (incremental ? "/dstarLite" : "/aStar"), [incremental](BenchmarkState &state)
+		{
+			const int numAgents = 200;
+			MotionPlanner *planner = nullptr;
+			state.itemsPerIteration = numAgents;
+			for (unsigned long long i = 0; i < state.iterations; i++)
+			{
+				if (i % 50 == 0)
+				{
+					delete planner;
+					planner = new MotionPlanner(1);
+					srand(1);
+					planner->mapSize = 80.0f;
+					addRandomObstacles(*planner, 20, 10);
+					addRandomCrowd(*planner, numAgents);
+					planner->numNewPos = 2000;
+					planner->roadmap.connection = CONNECT_K_NEAREST;
+					planner->aStar = true;
+					planner->incremental = incremental != 0;
+					planner->createRoadmap(1);
+				}
+				for (int step = 0; step < 10; step++)
+					planner->crowd.step();
+				planner->addBarrel(randomFreePoint(*planner));
+
+				currentTimer->begin();
+				for (int agent = 0; agent < numAgents; agent++)
+					planner->planPath(agent);
+				currentTimer->end();
+			}
+			delete planner;
+		});
+	}
+
+	// One crowd step per op, items are agents updated
+	int agentCounts[] = { 100, 1000, 5000 };
+	for (int n : agentCounts)
+	{
+		for (int simd = 1; simd >= 0; simd--)
+		{
+			addBenchmark("crowdStep/agents:" + to_string(n) + (simd ? "/simd" : "/scalar"), [n, simd](BenchmarkState &state)
+			{
+				MotionPlanner planner(1);
+				srand(1);
+				float scale = n / 16.0f;
+				planner.mapSize = 40.0f * sqrt(scale);
+				addRandomCrowd(planner, n);
+				planner.crowd.useSimd = simd != 0;
+				// Send everyone straight at their goal so the crowd is moving
+				for (int agent = 0; agent < n; agent++)
+				{
+					vector<glm::vec3> path;
+					path.push_back(planner.crowd.goals()[agent]);
+					path.push_back(planner.crowd.position(agent));
+					planner.crowd.setPath(agent, path);
+				}
+				for (int i = 0; i < 30; i++)
+					planner.crowd.step();
+
+				state.itemsPerIteration = n;
+				currentTimer->begin();
+				for (unsigned long long i = 0; i < state.iterations; i++)
+					planner.crowd.step();
+				currentTimer->end();
+			});
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	string filter;
+	double minTime = 0.5;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--filter" && i + 1 < argc)
+			filter = argv[++i];
+		else if (arg == "--min-time" && i + 1 < argc)
+			minTime = atof(argv[++i]);
+		else
+		{
+			printf("Unknown argument: %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	registerBenchmarks();
+
+	printf("%-48s %17s %12s %22s %20s\n", "Benchmark", "Time", "Iterations", "Throughput", "Allocations");
+	for (unsigned int i = 0; i < registry().size(); i++)
+	{
+		if (filter.empty() || registry()[i].name.find(filter) != string::npos)
+			runBenchmark(registry()[i], minTime);
+	}
+	return 0;
+}
@@ -1,9 +1,9 @@
-#version 330 core
-out vec4 FragColor;
-
-uniform vec4 col;
-
-void main()
-{
-    FragColor = col;//vec4(1.0f, 1.0f, 1.0f, 1.0f);
+#version 330 core
+out vec4 FragColor;
+
+uniform vec4 col;
+
+void main()
+{
+    FragColor = col;//vec4(1.0f, 1.0f, 1.0f, 1.0f);
 } 
\ No newline at end of file
@@ -0,0 +1,261 @@
+#ifndef DSTAR_LITE_H
+#define DSTAR_LITE_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "indexed_heap.h"
+#include "roadmap.h"
+
+// D* Lite (Koenig & Likhachev 2002) over a roadmap for one agent
+// The search runs back from the goal, so when the agent moves or edges are removed or nodes are added only the part of
+// the search tree that depends on them is repaired instead of searching from scratch
+// Changes don't have to be passed on straight away: a search can catch up on everything that happened since it last
+// ran just before it is next needed
+class DStarLite
+{
+public:
+	// Start a new search, computePath does the work
+	// removedSoFar is how much of the removed edge list (see edgesRemoved) the roadmap already reflects
+	void reset(const Roadmap &roadmap, unsigned int goalNode, unsigned int startNode, unsigned int removedSoFar = 0)
+	{
+		unsigned int numNodes = roadmap.numNodes();
+		goal = goalNode;
+		start = startNode;
+		km = 0.0f;
+		removalsSeen = removedSoFar;
+		g.assign(numNodes, INFINITY);
+		rhs.assign(numNodes, INFINITY);
+		open.reset(numNodes);
+
+		rhs[goal] = 0.0f;
+		open.push(goal, calcKey(roadmap, goal));
+	}
+
+	bool empty() const { return g.empty(); }
+	unsigned int goalNode() const { return goal; }
+
+	// The agent is now at startNode, eg a node just added at its position
+	void moveStart(const Roadmap &roadmap, unsigned int startNode)
+	{
+		km += heuristic(roadmap, start, startNode);
+		start = startNode;
+	}
+
+	// Call after nodes have been added to the roadmap, along with any edges to them
+	void nodesAdded(const Roadmap &roadmap)
+	{
+		unsigned int first = g.size();
+		unsigned int numNodes = roadmap.numNodes();
+		if (numNodes <= first)
+			return;
+		g.resize(numNodes, INFINITY);
+		rhs.resize(numNodes, INFINITY);
+		open.grow(numNodes);
+
+		// New nodes start unexplored, so only their own lookahead needs setting, nothing depends on them yet
+		for (unsigned int s = first; s < numNodes; s++)
+		{
+			rhs[s] = lookahead(roadmap, s);
+			updateVertex(roadmap, s);
+		}
+	}
+
+	// Catch up on removed edges, removedEdges holds Roadmap::edgeKey values and is only ever appended to
+	// Call nodesAdded first if nodes were added too
+	void edgesRemoved(const Roadmap &roadmap, const std::vector<unsigned long long> &removedEdges)
+	{
+		for (; removalsSeen < removedEdges.size(); removalsSeen++)
+		{
+			unsigned int u = removedEdges[removalsSeen] >> 32, v = removedEdges[removalsSeen] & 0xFFFFFFFFu;
+			float cost = searchCost(glm::length(roadmap.points[v] - roadmap.points[u])); // Same as Roadmap::connect worked it out
+			edgeIncreased(roadmap, u, v, cost);
+			edgeIncreased(roadmap, v, u, cost);
+		}
+	}
+
+	// Bring the search up to date and fill path with node indices from goal back to start like Roadmap::findPath,
+	// or just start if the goal can't be reached
+	bool computePath(const Roadmap &roadmap, std::vector<unsigned int> &path)
+	{
+		computeShortestPath(roadmap);
+
+		// The start can be left overconsistent, so its lookahead rather than g says whether the goal is reachable
+		path.clear();
+		if (rhs[start] == INFINITY)
+		{
+			path.push_back(start);
+			return false;
+		}
+
+		// Walk down g from the start, then flip so the goal comes first
+		// Nodes at the same position are joined by zero cost edges and can tie on g, so nodes already on the path are
+		// skipped, otherwise two of them would keep picking each other. Ties go to the neighbour nearer the goal
+		onPath.resize(g.size(), 0);
+		unsigned int current = start;
+		path.push_back(current);
+		onPath[current] = 1;
+		while (current != goal)
+		{
+			unsigned int best = current;
+			float bestCost = INFINITY;
+			for (unsigned int e = roadmap.edgeOffsets[current]; e < roadmap.edgeOffsets[current + 1]; e++)
+			{
+				unsigned int s = roadmap.edgeTargets[e];
+				float cost = searchCost(roadmap.edgeCosts[e]) + g[s];
+				if (!onPath[s] && (cost < bestCost || (cost == bestCost && g[s] < g[best])))
+				{
+					bestCost = cost;
+					best = s;
+				}
+			}
+			if (best == current)
+				break;
+			current = best;
+			path.push_back(current);
+			onPath[current] = 1;
+		}
+		for (unsigned int i = 0; i < path.size(); i++)
+			onPath[path[i]] = 0;
+
+		// Stuck short of the goal counts as unreachable, rather than handing back a path that doesn't get there
+		if (current != goal)
+		{
+			path.assign(1, start);
+			return false;
+		}
+		std::reverse(path.begin(), path.end());
+		return true;
+	}
+
+private:
+	// Priority is compared on k1 first, then k2
+	struct Key
+	{
+		float k1 = 0.0f, k2 = 0.0f;
+
+		bool operator<(const Key &other) const
+		{
+			return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2);
+		}
+	};
+
+	unsigned int goal = 0, start = 0;
+	unsigned int removalsSeen = 0;
+	float km = 0.0f;        // Total heuristic change from the start moving
+	std::vector<float> g;   // Cost to goal as of the last expansion
+	std::vector<float> rhs; // One step lookahead of g
+	BasicIndexedHeap<Key> open;
+	std::vector<unsigned char> onPath; // Nodes on the path computePath is walking, all clear between calls
+
+	// Nodes at the same position (a replan start where an agent hasn't moved, or on another agent's goal) are joined by
+	// zero length edges. D* Lite needs every edge to cost something: with a free edge two such nodes can keep each other's
+	// g up after the edges they really depended on are removed, and never be seen as underconsistent
+	// Costs stay at least the straight line length, so the heuristic is still consistent
+	static float searchCost(float edgeCost)
+	{
+		const float minCost = 1e-3f; // Well above float resolution at roadmap path lengths
+		return std::max(edgeCost, minCost);
+	}
+
+	static float heuristic(const Roadmap &roadmap, unsigned int a, unsigned int b)
+	{
+		return glm::length(roadmap.points[a] - roadmap.points[b]);
+	}
+
+	Key calcKey(const Roadmap &roadmap, unsigned int s) const
+	{
+		Key k;
+		k.k2 = std::min(g[s], rhs[s]);
+		k.k1 = k.k2 + heuristic(roadmap, start, s) + km;
+		return k;
+	}
+
+	float lookahead(const Roadmap &roadmap, unsigned int s) const
+	{
+		if (s == goal)
+			return 0.0f;
+		float best = INFINITY;
+		for (unsigned int e = roadmap.edgeOffsets[s]; e < roadmap.edgeOffsets[s + 1]; e++)
+			best = std::min(best, searchCost(roadmap.edgeCosts[e]) + g[roadmap.edgeTargets[e]]);
+		return best;
+	}
+
+	void updateVertex(const Roadmap &roadmap, unsigned int s)
+	{
+		if (g[s] != rhs[s])
+		{
+			if (open.contains(s))
+				open.update(s, calcKey(roadmap, s));
+			else
+				open.push(s, calcKey(roadmap, s));
+		}
+		else
+		{
+			open.remove(s);
+		}
+	}
+
+	// u's edge to v got more expensive, only matters if it was u's best way to the goal
+	void edgeIncreased(const Roadmap &roadmap, unsigned int u, unsigned int v, float oldCost)
+	{
+		if (u >= g.size() || v >= g.size() || u == goal)
+			return;
+		if (rhs[u] == oldCost + g[v])
+		{
+			rhs[u] = lookahead(roadmap, u);
+			updateVertex(roadmap, u);
+		}
+	}
+
+	void computeShortestPath(const Roadmap &roadmap)
+	{
+		while (!open.empty() && (open.topKey() < calcKey(roadmap, start) || rhs[start] > g[start]))
+		{
+			unsigned int u = open.top();
+			Key oldKey = open.topKey();
+			Key newKey = calcKey(roadmap, u);
+			if (oldKey < newKey)
+			{
+				// Key is stale from the start moving
+				open.update(u, newKey);
+			}
+			else if (g[u] > rhs[u])
+			{
+				// Overconsistent, settle it and offer it to the neighbours
+				g[u] = rhs[u];
+				open.remove(u);
+				for (unsigned int e = roadmap.edgeOffsets[u]; e < roadmap.edgeOffsets[u + 1]; e++)
+				{
+					unsigned int s = roadmap.edgeTargets[e];
+					if (s != goal)
+					{
+						rhs[s] = std::min(rhs[s], searchCost(roadmap.edgeCosts[e]) + g[u]);
+						updateVertex(roadmap, s);
+					}
+				}
+			}
+			else
+			{
+				// Underconsistent, raise it and fix up anything that went through it
+				float oldG = g[u];
+				g[u] = INFINITY;
+				for (unsigned int e = roadmap.edgeOffsets[u]; e < roadmap.edgeOffsets[u + 1]; e++)
+				{
+					unsigned int s = roadmap.edgeTargets[e];
+					if (s != goal && rhs[s] == searchCost(roadmap.edgeCosts[e]) + oldG)
+						rhs[s] = lookahead(roadmap, s);
+					updateVertex(roadmap, s);
+				}
+				if (u != goal)
+					rhs[u] = lookahead(roadmap, u);
+				updateVertex(roadmap, u);
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,119 @@
+// Regression cases for DStarLite on roadmaps with nodes at the same position, joined by zero length edges
+// Usage: dstar_lite_test
+// Prints each case and exits non-zero if any path loops, doesn't run from the goal to the start, or costs more than
+// a fresh A* over the same roadmap
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "dstar_lite.h"
+
+using namespace std;
+
+static int failures = 0;
+
+// Keep only the edges listed as pairs of node indices
+void keepEdges(Roadmap &roadmap, ThreadPool &pool, const vector<unsigned int> &pairs)
+{
+	ObstacleGrid::Box everywhere = { glm::vec2(-1e6f, -1e6f), glm::vec2(1e6f, 1e6f) };
+	vector<unsigned long long> removed;
+	roadmap.removeEdges(everywhere, [&](glm::vec2 p1, glm::vec2 p2)
+	{
+		for (unsigned int k = 0; k + 1 < pairs.size(); k += 2)
+		{
+			glm::vec2 a = glm::vec2(roadmap.points[pairs[k]][0], roadmap.points[pairs[k]][2]);
+			glm::vec2 b = glm::vec2(roadmap.points[pairs[k + 1]][0], roadmap.points[pairs[k + 1]][2]);
+			if ((a == p1 && b == p2) || (a == p2 && b == p1))
+				return false;
+		}
+		return true;
+	}, pool, removed);
+}
+
+float pathCost(const Roadmap &roadmap, const vector<unsigned int> &path)
+{
+	float cost = 0.0f;
+	for (unsigned int i = 1; i < path.size(); i++)
+		cost += glm::length(roadmap.points[path[i]] - roadmap.points[path[i - 1]]);
+	return cost;
+}
+
+void checkPath(const char *name, const Roadmap &roadmap, DStarLite &search, unsigned int start, unsigned int goal)
+{
+	vector<unsigned int> path, best;
+	bool found = search.computePath(roadmap, path);
+	roadmap.findPath(start, goal, true, best);
+
+	bool ok = found && !path.empty() && path.front() == goal && path.back() == start;
+	for (unsigned int i = 0; ok && i < path.size(); i++)
+	{
+		for (unsigned int j = i + 1; j < path.size(); j++)
+			ok = ok && path[i] != path[j];
+	}
+	ok = ok && fabs(pathCost(roadmap, path) - pathCost(roadmap, best)) < 1e-4f;
+
+	printf("%-40s %s  (%u nodes, cost %g, A* cost %g)\n", name, ok ? "ok  " : "FAIL", (unsigned int)path.size(),
+		pathCost(roadmap, path), pathCost(roadmap, best));
+	if (!ok)
+		failures++;
+}
+
+int main()
+{
+	ObstacleSet obstacles;
+	ThreadPool pool(1);
+
+	// Two nodes on top of each other beside the start's way to the goal. Once both have been settled from an earlier
+	// start, walking from either tied on g with the other and went back and forth between them
+	{
+		Roadmap roadmap;
+		roadmap.addPoint(glm::vec3(0.0f, 0.0f, 0.0f));  // 0 A
+		roadmap.addPoint(glm::vec3(0.0f, 0.0f, 0.0f));  // 1 B, same place
+		roadmap.addPoint(glm::vec3(5.0f, 0.0f, 0.0f));  // 2
+		roadmap.addPoint(glm::vec3(10.0f, 0.0f, 0.0f)); // 3 goal
+		roadmap.addPoint(glm::vec3(-5.0f, 0.0f, 0.0f)); // 4 first start
+		roadmap.connect(obstacles, pool);
+
+		DStarLite search;
+		search.reset(roadmap, 3, 4);
+		checkPath("coincident/first start", roadmap, search, 4, 3);
+		search.moveStart(roadmap, 0);
+		checkPath("coincident/start on first node", roadmap, search, 0, 3);
+		search.moveStart(roadmap, 1);
+		checkPath("coincident/start on second node", roadmap, search, 1, 3);
+	}
+
+	// Both coincident nodes lose the edges their route went through. With a free edge between them each could keep the
+	// other's old g up, so the start still went their way instead of around through Z
+	{
+		Roadmap roadmap;
+		roadmap.addPoint(glm::vec3(0.0f, 0.0f, 0.0f));   // 0 A
+		roadmap.addPoint(glm::vec3(0.0f, 0.0f, 0.0f));   // 1 B, same place
+		roadmap.addPoint(glm::vec3(5.0f, 0.0f, 5.0f));   // 2 X, the short way on
+		roadmap.addPoint(glm::vec3(5.0f, 0.0f, -6.0f));  // 3 Y, the long way on
+		roadmap.addPoint(glm::vec3(10.0f, 0.0f, 0.0f));  // 4 goal
+		roadmap.addPoint(glm::vec3(-5.0f, 0.0f, 0.0f));  // 5 start
+		roadmap.addPoint(glm::vec3(2.5f, 0.0f, 6.61f));  // 6 Z, between the two
+		roadmap.connect(obstacles, pool);
+		keepEdges(roadmap, pool, { 5, 0, 5, 1, 0, 1, 0, 2, 1, 2, 0, 3, 1, 3, 2, 4, 3, 4, 5, 6, 6, 4 });
+
+		DStarLite search;
+		search.reset(roadmap, 4, 5);
+		checkPath("coincident/before removal", roadmap, search, 5, 4);
+
+		// Cut A-X and B-X and pass the removals on like MotionPlanner does
+		vector<unsigned long long> removed;
+		ObstacleGrid::Box bounds = { glm::vec2(-1.0f, -1.0f), glm::vec2(6.0f, 6.0f) };
+		roadmap.removeEdges(bounds, [](glm::vec2 p1, glm::vec2 p2)
+		{
+			glm::vec2 a = glm::vec2(0.0f, 0.0f), x = glm::vec2(5.0f, 5.0f);
+			return (p1 == a && p2 == x) || (p1 == x && p2 == a);
+		}, pool, removed);
+		search.edgesRemoved(roadmap, removed);
+		checkPath("coincident/after removal", roadmap, search, 5, 4);
+	}
+
+	printf("%d failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "indexed_heap.h"
+#include "roadmap.h"
+
+// Shortest path tree over a roadmap towards one goal node
+// Built with a single Dijkstra outward from the goal (edges are undirected), after which every agent heading to that
+// goal reads its path off the next hop table instead of running its own search
+class FlowField
+{
+public:
+	enum : unsigned int { NO_NEXT = 0xFFFFFFFFu };
+
+	unsigned int goal = 0;
+	std::vector<float> costToGoal;      // INFINITY where the goal can't be reached
+	std::vector<unsigned int> nextHop;  // Neighbour one step closer to the goal, NO_NEXT at the goal or if unreachable
+
+	void build(const Roadmap &roadmap, unsigned int goalNode)
+	{
+		unsigned int numNodes = roadmap.numNodes();
+		goal = goalNode;
+		costToGoal.assign(numNodes, INFINITY);
+		nextHop.assign(numNodes, NO_NEXT);
+		fringe.reset(numNodes);
+
+		costToGoal[goal] = 0.0f;
+		fringe.push(goal, 0.0f);
+		while (!fringe.empty())
+		{
+			unsigned int current = fringe.pop();
+			for (unsigned int e = roadmap.edgeOffsets[current]; e < roadmap.edgeOffsets[current + 1]; e++)
+			{
+				unsigned int lookingAt = roadmap.edgeTargets[e];
+				float cost = costToGoal[current] + roadmap.edgeCosts[e];
+				if (cost < costToGoal[lookingAt])
+				{
+					costToGoal[lookingAt] = cost;
+					nextHop[lookingAt] = current;
+					fringe.push(lookingAt, cost);
+				}
+			}
+		}
+	}
+
+	// Nodes built after the field was don't have an entry and count as unreachable
+	bool reaches(unsigned int node) const
+	{
+		return node < costToGoal.size() && costToGoal[node] != INFINITY;
+	}
+
+	// True if the tree uses the edge between a and b, so removing that edge makes the field stale
+	bool usesEdge(unsigned int a, unsigned int b) const
+	{
+		return (a < nextHop.size() && nextHop[a] == b) || (b < nextHop.size() && nextHop[b] == a);
+	}
+
+	// Fill path with node indices from goal back to start like Roadmap::findPath, or just start if the goal can't be
+	// reached
+	bool pathFrom(unsigned int start, std::vector<unsigned int> &path) const
+	{
+		path.clear();
+		if (!reaches(start))
+		{
+			path.push_back(start);
+			return false;
+		}
+		for (unsigned int current = start; current != NO_NEXT; current = nextHop[current])
+			path.push_back(current);
+		std::reverse(path.begin(), path.end());
+		return true;
+	}
+
+private:
+	IndexedHeap fringe; // Kept between builds so rebuilding doesn't reallocate
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <learn_opengl/shader.h>
+
+// Camera and light values for one frame, laid out like the std140 "Frame" block in the shaders:
+//	layout (std140) uniform Frame { mat4 view; mat4 projection; vec3 viewPos; Light light; };
+// vec3s take 16 bytes in std140 so they're vec4s here, w unused
+struct FrameUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 viewPos;
+	glm::vec4 lightDirection;
+	glm::vec4 lightAmbient;
+	glm::vec4 lightDiffuse;
+	glm::vec4 lightSpecular;
+};
+static_assert(sizeof(FrameUniforms) == 208, "FrameUniforms must match the std140 Frame block");
+
+// One uniform buffer holding FrameUniforms, bound to every shader that declares the Frame block, so the per frame
+// values are uploaded once instead of set by name on each program
+class FrameUniformBuffer
+{
+public:
+	enum : unsigned int { BINDING = 0 };
+
+	void create()
+	{
+		glGenBuffers(1, &UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	// Point the shader's Frame block at the buffer, once after the shader is compiled
+	void attach(const Shader &shader) const
+	{
+		unsigned int block = glGetUniformBlockIndex(shader.ID, "Frame");
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(shader.ID, block, BINDING);
+	}
+
+	void upload(const FrameUniforms &frame) const
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+private:
+	unsigned int UBO = 0;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+
+// 64 bit FNV-1a, for checking whether cached data was built from the same inputs
+enum : unsigned long long { FNV_OFFSET_BASIS = 14695981039346656037ull, FNV_PRIME = 1099511628211ull };
+
+inline void hashBytes(unsigned long long &h, const void *data, size_t size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		h ^= bytes[i];
+		h *= FNV_PRIME;
+	}
+}
+
+#endif
@@ -0,0 +1,238 @@
+// Headless runner: builds the roadmap, plans and steps the crowd with no window or OpenGL
+// Usage: headless [--agents N] [--samples N] [--steps N] [--threads N] [--seed N] [--connect all|knn|radius] [--k N]
+//                 [--radius R] [--lazy] [--cache FILE] [--exits N] [--shared-goals] [--no-smooth] [--astar]
+//                 [--scalar] [--scenario FILE] [--save-scenario FILE] [--profile FILE]
+//   --agents N   random crowd of N agents instead of the default scenario
+//   --exits N    with --agents, send the crowd to N random exits instead of a goal each
+//   --samples N  number of random roadmap samples (default 150)
+//   --steps N    fixed simulation steps to run (default 1000)
+//   --threads N  simulation worker threads, 0 for one per core (default 0)
+//   --seed N     random seed for the roadmap and crowd (default 1)
+//   --connect S  roadmap connection strategy: every pair, k nearest or within a radius (default all)
+//   --k N        neighbours for --connect knn, 0 for the PRM* value (default 0)
+//   --radius R   radius for --connect radius, 0 for the PRM* value (default 0)
+//   --lazy       only test the roadmap edges that paths use (LazyPRM)
+//   --cache FILE reuse the roadmap saved in FILE if it matches the obstacles and settings, otherwise build and save it
+//   --shared-goals  one flow field per distinct goal instead of a search per agent
+//   --no-smooth  leave paths as found on the roadmap instead of cutting out the waypoints agents can skip
+//   --astar      A* instead of uniform cost search, which the viewer also starts with
+//   --scalar     scalar TTC kernel instead of SIMD
+//   --scenario FILE       load the map, crowd and obstacles from a text or binary scenario file
+//   --save-scenario FILE  write the scenario being run to FILE, binary if it ends in .bin, before planning
+//   --profile FILE  record timers and counters and write them to FILE at exit, as a Chrome trace if it ends in .json
+//                   and CSV otherwise
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "planner.h"
+#include "profile.h"
+#include "scenario.h"
+#include "scenario_file.h"
+
+using namespace std;
+
+double msSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+	int numAgents = 0;
+	int numExits = 0;
+	int numSamples = 150;
+	int numSteps = 1000;
+	unsigned int numThreads = 0;
+	unsigned int seed = 1;
+	bool aStar = false;
+	bool useSimd = true;
+	bool sharedGoals = false;
+	bool smoothPaths = true;
+	ConnectionStrategy connection = CONNECT_ALL;
+	unsigned int connectK = 0;
+	float connectRadius = 0.0f;
+	bool lazy = false;
+	string roadmapCache;
+	string scenarioFile, saveScenario;
+	string profileFile;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--agents" && hasValue)
+			numAgents = atoi(argv[++i]);
+		else if (arg == "--samples" && hasValue)
+			numSamples = atoi(argv[++i]);
+		else if (arg == "--steps" && hasValue)
+			numSteps = atoi(argv[++i]);
+		else if (arg == "--threads" && hasValue)
+			numThreads = atoi(argv[++i]);
+		else if (arg == "--seed" && hasValue)
+			seed = atoi(argv[++i]);
+		else if (arg == "--connect" && hasValue)
+		{
+			string strategy = argv[++i];
+			if (strategy == "all")
+				connection = CONNECT_ALL;
+			else if (strategy == "knn")
+				connection = CONNECT_K_NEAREST;
+			else if (strategy == "radius")
+				connection = CONNECT_RADIUS;
+			else
+			{
+				cout << "Unknown connection strategy: " << strategy << endl;
+				return 1;
+			}
+		}
+		else if (arg == "--k" && hasValue)
+			connectK = atoi(argv[++i]);
+		else if (arg == "--radius" && hasValue)
+			connectRadius = (float)atof(argv[++i]);
+		else if (arg == "--lazy")
+			lazy = true;
+		else if (arg == "--cache" && hasValue)
+			roadmapCache = argv[++i];
+		else if (arg == "--exits" && hasValue)
+			numExits = atoi(argv[++i]);
+		else if (arg == "--shared-goals")
+			sharedGoals = true;
+		else if (arg == "--no-smooth")
+			smoothPaths = false;
+		else if (arg == "--astar")
+			aStar = true;
+		else if (arg == "--scalar")
+			useSimd = false;
+		else if (arg == "--scenario" && hasValue)
+			scenarioFile = argv[++i];
+		else if (arg == "--save-scenario" && hasValue)
+			saveScenario = argv[++i];
+		else if (arg == "--profile" && hasValue)
+			profileFile = argv[++i];
+		else
+		{
+			cout << "Unknown argument: " << arg << endl;
+			return 1;
+		}
+	}
+
+	Profiler &profiler = Profiler::instance();
+	profiler.setEnabled(!profileFile.empty());
+
+	MotionPlanner planner(numThreads);
+	planner.numNewPos = numSamples;
+	planner.aStar = aStar;
+	planner.sharedGoals = sharedGoals;
+	planner.smoothPaths = smoothPaths;
+	planner.crowd.useSimd = useSimd;
+	planner.roadmap.connection = connection;
+	planner.roadmap.connectK = connectK;
+	planner.roadmap.connectRadius = connectRadius;
+	planner.roadmap.lazy = lazy;
+	planner.roadmapCache = roadmapCache;
+
+	srand(seed);
+	if (!scenarioFile.empty())
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		string error;
+		if (!loadScenarioFile(planner, scenarioFile, error))
+		{
+			cout << error << endl;
+			return 1;
+		}
+		cout << "Loaded " << scenarioFile << " in " << msSince(start) << " ms" << endl;
+	}
+	else if (numAgents > 0)
+	{
+		// Grow the map and obstacle count with the crowd so density matches the default scenario
+		float scale = numAgents / 16.0f;
+		planner.mapSize = 40.0f * sqrt(scale);
+		addRandomObstacles(planner, (int)(6 * scale), (int)(3 * scale));
+		if (numExits > 0)
+			addExitCrowd(planner, numAgents, numExits);
+		else
+			addRandomCrowd(planner, numAgents);
+	}
+	else
+	{
+		loadDefaultScenario(planner);
+	}
+
+	cout << "Agents: " << planner.crowd.numAgents() << ", barrels: " << planner.obstacles.barrelPos.size()
+		<< ", cars: " << planner.obstacles.carPos.size() << ", threads: " << planner.crowd.numThreads() << endl;
+
+	if (!saveScenario.empty())
+	{
+		bool binary = saveScenario.size() >= 4 && saveScenario.compare(saveScenario.size() - 4, 4, ".bin") == 0;
+		if (!saveScenarioFile(planner, saveScenario, binary))
+		{
+			cout << "Can't write " << saveScenario << endl;
+			return 1;
+		}
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	planner.buildRoadmap(seed);
+	double roadmapMs = msSince(start);
+
+	start = chrono::steady_clock::now();
+	planner.planPaths();
+	double searchMs = msSince(start);
+
+	cout << "Roadmap: " << planner.roadmap.numNodes() << " nodes, " << planner.roadmap.numEdges() << " edges" << endl;
+	cout << "Planning: " << roadmapMs + searchMs << " ms (roadmap " << roadmapMs << " ms, " << (sharedGoals ? "flow fields" : aStar ? "A*" : "uniform cost search")
+		<< " " << searchMs << " ms)" << endl;
+
+	double pathLength = 0.0;
+	unsigned int numWaypoints = 0;
+	for (unsigned int agent = 0; agent < planner.crowd.numAgents(); agent++)
+	{
+		const vector<unsigned int> &path = planner.agentPaths[agent];
+		for (unsigned int m = 1; m < path.size(); m++)
+			pathLength += glm::length(planner.roadmap.points[path[m]] - planner.roadmap.points[path[m - 1]]);
+		numWaypoints += path.size();
+	}
+	cout << "Paths: " << pathLength / planner.crowd.numAgents() << " long, " << (double)numWaypoints / planner.crowd.numAgents()
+		<< " waypoints per agent" << endl;
+
+	start = chrono::steady_clock::now();
+	for (int i = 0; i < numSteps; i++)
+		planner.crowd.step();
+	double simMs = msSince(start);
+
+	double stepsPerSec = numSteps / (simMs / 1000.0);
+	cout << "Simulation: " << numSteps << " steps in " << simMs << " ms" << endl;
+	cout << "  " << stepsPerSec << " steps/sec, " << stepsPerSec * planner.crowd.numAgents() << " agent-steps/sec" << endl;
+
+	if (!profileFile.empty())
+	{
+		profiler.setEnabled(false);
+		const char *timers[] = { "buildRoadmap", "sampleRoadmap", "findNeighbours", "connectRoadmap", "checkEdges", "planPaths",
+			"findPaths", "findValidPaths", "buildFlowFields", "crowdStep", "crowdBroadPhase", "crowdForces", "crowdIntegrate" };
+		cout << "Profile:" << endl;
+		for (const char *name : timers)
+		{
+			double ms;
+			unsigned long long calls;
+			profiler.totals(name, ms, calls);
+			if (calls > 0)
+				cout << "  " << name << ": " << ms << " ms over " << calls << " calls" << endl;
+		}
+		for (unsigned int c = 0; c < NUM_COUNTERS; c++)
+			cout << "  " << profileCounterName(c) << ": " << profiler.counterValue(c) << endl;
+
+		bool json = profileFile.size() >= 5 && profileFile.compare(profileFile.size() - 5, 5, ".json") == 0;
+		if (!(json ? profiler.writeChromeTrace(profileFile) : profiler.writeCsv(profileFile)))
+		{
+			cout << "Can't write " << profileFile << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <vector>
+
+// Binary min-heap over node indices [0, n) keyed by cost (any Key with operator<)
+// Keeps the heap slot of every node so decreaseKey is O(log n) instead of a linear fringe scan
+template <typename Key>
+class BasicIndexedHeap
+{
+public:
+	BasicIndexedHeap(unsigned int numNodes = 0)
+	{
+		reset(numNodes);
+	}
+
+	// Empty the heap and make room for numNodes indices
+	void reset(unsigned int numNodes)
+	{
+		heap.clear();
+		keys.assign(numNodes, Key());
+		slot.assign(numNodes, NOT_IN_HEAP);
+	}
+
+	// Make room for more indices, keeping what is in the heap
+	void grow(unsigned int numNodes)
+	{
+		if (numNodes <= slot.size())
+			return;
+		keys.resize(numNodes, Key());
+		slot.resize(numNodes, NOT_IN_HEAP);
+	}
+
+	// Empty the heap keeping its size, only touching the nodes still in it
+	void clear()
+	{
+		for (unsigned int i = 0; i < heap.size(); i++)
+			slot[heap[i]] = NOT_IN_HEAP;
+		heap.clear();
+	}
+
+	bool empty() const { return heap.empty(); }
+	unsigned int size() const { return heap.size(); }
+	bool contains(unsigned int node) const { return slot[node] != NOT_IN_HEAP; }
+	Key key(unsigned int node) const { return keys[node]; }
+	unsigned int top() const { return heap[0]; }
+	Key topKey() const { return keys[heap[0]]; }
+
+	// Insert node, or lower its key if it is already in the heap
+	void push(unsigned int node, Key k)
+	{
+		if (contains(node))
+		{
+			if (k < keys[node])
+			{
+				keys[node] = k;
+				siftUp(slot[node]);
+			}
+			return;
+		}
+		keys[node] = k;
+		slot[node] = heap.size();
+		heap.push_back(node);
+		siftUp(heap.size() - 1);
+	}
+
+	// Set the key of a node already in the heap (either direction)
+	void update(unsigned int node, Key k)
+	{
+		Key old = keys[node];
+		keys[node] = k;
+		if (k < old)
+			siftUp(slot[node]);
+		else
+			siftDown(slot[node]);
+	}
+
+	unsigned int pop()
+	{
+		unsigned int node = heap[0];
+		removeAt(0);
+		return node;
+	}
+
+	void remove(unsigned int node)
+	{
+		if (contains(node))
+			removeAt(slot[node]);
+	}
+
+private:
+	enum : unsigned int { NOT_IN_HEAP = 0xFFFFFFFFu };
+
+	std::vector<unsigned int> heap; // Node indices in heap order
+	std::vector<Key> keys;          // Key of each node
+	std::vector<unsigned int> slot; // Position of each node in heap, or NOT_IN_HEAP
+
+	void removeAt(unsigned int i)
+	{
+		unsigned int node = heap[i];
+		unsigned int last = heap.back();
+		heap.pop_back();
+		slot[node] = NOT_IN_HEAP;
+		if (i < heap.size())
+		{
+			heap[i] = last;
+			slot[last] = i;
+			siftUp(i);
+			siftDown(slot[last]);
+		}
+	}
+
+	void siftUp(unsigned int i)
+	{
+		unsigned int node = heap[i];
+		Key k = keys[node];
+		while (i > 0)
+		{
+			unsigned int parent = (i - 1) / 2;
+			if (!(k < keys[heap[parent]]))
+				break;
+			heap[i] = heap[parent];
+			slot[heap[i]] = i;
+			i = parent;
+		}
+		heap[i] = node;
+		slot[node] = i;
+	}
+
+	void siftDown(unsigned int i)
+	{
+		unsigned int node = heap[i];
+		Key k = keys[node];
+		unsigned int n = heap.size();
+		while (true)
+		{
+			unsigned int child = 2 * i + 1;
+			if (child >= n)
+				break;
+			if (child + 1 < n && keys[heap[child + 1]] < keys[heap[child]])
+				child++;
+			if (!(keys[heap[child]] < k))
+				break;
+			heap[i] = heap[child];
+			slot[heap[i]] = i;
+			i = child;
+		}
+		heap[i] = node;
+		slot[node] = i;
+	}
+};
+
+typedef BasicIndexedHeap<float> IndexedHeap;
+
+#endif
@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel; // Per instance, takes locations 3-6
+
+out vec3 FragCoord;
+out vec3 Normal;
+out vec2 TexCoord;
+
+struct Light {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// Per frame values from one uniform buffer, see frame_uniforms.h. Must match in every shader that declares it
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    Light light;
+};
+
+void main()
+{
+	FragCoord = vec3(aModel * vec4(aPos, 1.0));
+	// Instances are only rotated and uniformly scaled, so the normal matrix is the model matrix up to a scale the
+	// fragment shader normalizes away
+	Normal = mat3(aModel) * aNormal;
+	TexCoord = aTexCoord;
+
+	gl_Position = projection * view * vec4(FragCoord, 1.0);
+}
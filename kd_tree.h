@@ -0,0 +1,175 @@
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Static 2D k-d tree over the x/z coordinates of a point set, for nearest neighbour and radius queries
+// The tree is implicit: each range of the point order is split at its median, which is stored at the middle index
+class KdTree
+{
+public:
+	void build(const std::vector<glm::vec3> &points)
+	{
+		unsigned int n = points.size();
+		std::vector<Entry> entries(n);
+		for (unsigned int i = 0; i < n; i++)
+		{
+			entries[i].pos = glm::vec2(points[i][0], points[i][2]);
+			entries[i].index = i;
+		}
+
+		splitAxis.assign(n, 0);
+		buildRange(entries, 0, n);
+
+		order.resize(n);
+		pos.resize(n);
+		for (unsigned int k = 0; k < n; k++)
+		{
+			order[k] = entries[k].index;
+			pos[k] = entries[k].pos;
+		}
+	}
+
+	unsigned int size() const { return order.size(); }
+
+	// Up to k point indices closest to p, nearest first, leaving out the point with index exclude
+	void kNearest(glm::vec2 p, unsigned int k, unsigned int exclude, std::vector<unsigned int> &out) const
+	{
+		out.clear();
+		if (k == 0)
+			return;
+
+		std::vector<std::pair<float, unsigned int>> best; // Max heap on distance, so the worst is at the front
+		best.reserve(k + 1);
+		nearestRange(p, k, exclude, 0, order.size(), best);
+
+		std::sort_heap(best.begin(), best.end());
+		for (unsigned int i = 0; i < best.size(); i++)
+			out.push_back(best[i].second);
+	}
+
+	// All point indices within r of p, in no particular order
+	void withinRadius(glm::vec2 p, float r, std::vector<unsigned int> &out) const
+	{
+		out.clear();
+		radiusRange(p, r * r, 0, order.size(), out);
+	}
+
+private:
+	enum { LEAF_SIZE = 8 };
+
+	std::vector<unsigned int> order;      // Point indices in tree order
+	std::vector<glm::vec2> pos;           // Positions in tree order
+	std::vector<unsigned char> splitAxis; // For each internal node (middle of its range), 0 for x or 1 for z
+
+	// Points are partitioned by value rather than through the index, which keeps the median searches in cache
+	struct Entry
+	{
+		glm::vec2 pos;
+		unsigned int index;
+	};
+
+	void buildRange(std::vector<Entry> &entries, unsigned int lo, unsigned int hi)
+	{
+		if (hi - lo <= LEAF_SIZE)
+			return;
+
+		// Split along the wider side of the range's bounding box
+		glm::vec2 mn = entries[lo].pos, mx = mn;
+		for (unsigned int k = lo + 1; k < hi; k++)
+		{
+			mn = glm::min(mn, entries[k].pos);
+			mx = glm::max(mx, entries[k].pos);
+		}
+		int axis = (mx[0] - mn[0] >= mx[1] - mn[1]) ? 0 : 1;
+
+		unsigned int mid = (lo + hi) / 2;
+		std::nth_element(entries.begin() + lo, entries.begin() + mid, entries.begin() + hi, [axis](const Entry &a, const Entry &b)
+		{
+			return a.pos[axis] < b.pos[axis];
+		});
+		splitAxis[mid] = axis;
+
+		buildRange(entries, lo, mid);
+		buildRange(entries, mid + 1, hi);
+	}
+
+	void offerNearest(glm::vec2 p, unsigned int k, unsigned int exclude, unsigned int slot, std::vector<std::pair<float, unsigned int>> &best) const
+	{
+		if (order[slot] == exclude)
+			return;
+		glm::vec2 d = pos[slot] - p;
+		float dist2 = glm::dot(d, d);
+		if (best.size() < k)
+		{
+			best.push_back(std::make_pair(dist2, order[slot]));
+			std::push_heap(best.begin(), best.end());
+		}
+		else if (dist2 < best.front().first)
+		{
+			std::pop_heap(best.begin(), best.end());
+			best.back() = std::make_pair(dist2, order[slot]);
+			std::push_heap(best.begin(), best.end());
+		}
+	}
+
+	void nearestRange(glm::vec2 p, unsigned int k, unsigned int exclude, unsigned int lo, unsigned int hi, std::vector<std::pair<float, unsigned int>> &best) const
+	{
+		if (hi - lo <= LEAF_SIZE)
+		{
+			for (unsigned int slot = lo; slot < hi; slot++)
+				offerNearest(p, k, exclude, slot, best);
+			return;
+		}
+
+		unsigned int mid = (lo + hi) / 2;
+		int axis = splitAxis[mid];
+		float diff = p[axis] - pos[mid][axis];
+		offerNearest(p, k, exclude, mid, best);
+
+		// Near side first, then the far side only if it could still hold something closer
+		if (diff < 0.0f)
+			nearestRange(p, k, exclude, lo, mid, best);
+		else
+			nearestRange(p, k, exclude, mid + 1, hi, best);
+		if (best.size() < k || diff * diff < best.front().first)
+		{
+			if (diff < 0.0f)
+				nearestRange(p, k, exclude, mid + 1, hi, best);
+			else
+				nearestRange(p, k, exclude, lo, mid, best);
+		}
+	}
+
+	void radiusRange(glm::vec2 p, float r2, unsigned int lo, unsigned int hi, std::vector<unsigned int> &out) const
+	{
+		if (hi - lo <= LEAF_SIZE)
+		{
+			for (unsigned int slot = lo; slot < hi; slot++)
+			{
+				glm::vec2 d = pos[slot] - p;
+				if (glm::dot(d, d) <= r2)
+					out.push_back(order[slot]);
+			}
+			return;
+		}
+
+		unsigned int mid = (lo + hi) / 2;
+		int axis = splitAxis[mid];
+		float diff = p[axis] - pos[mid][axis];
+		glm::vec2 d = pos[mid] - p;
+		if (glm::dot(d, d) <= r2)
+			out.push_back(order[mid]);
+
+		if (diff <= 0.0f || diff * diff <= r2)
+			radiusRange(p, r2, lo, mid, out);
+		if (diff >= 0.0f || diff * diff <= r2)
+			radiusRange(p, r2, mid + 1, hi, out);
+	}
+};
+
+#endif
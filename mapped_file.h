@@ -0,0 +1,100 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read only memory mapping of a whole file, unmapped when destroyed
+class MappedFile
+{
+public:
+	MappedFile() {}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// Returns false if the file can't be opened or is empty
+	bool open(const std::string &fileName)
+	{
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (mapping == NULL)
+			return false;
+		void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (view == NULL)
+			return false;
+		bytes = static_cast<const unsigned char *>(view);
+		length = (size_t)fileSize.QuadPart;
+#else
+		int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0)
+		{
+			::close(fd);
+			return false;
+		}
+		void *view = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (view == MAP_FAILED)
+			return false;
+		bytes = static_cast<const unsigned char *>(view);
+		length = info.st_size;
+#endif
+		return true;
+	}
+
+	void close()
+	{
+		if (!bytes)
+			return;
+#ifdef _WIN32
+		UnmapViewOfFile(bytes);
+#else
+		munmap(const_cast<unsigned char *>(bytes), length);
+#endif
+		bytes = nullptr;
+		length = 0;
+	}
+
+	const unsigned char *data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char *bytes = nullptr;
+	size_t length = 0;
+};
+
+#endif
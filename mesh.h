@@ -1,107 +1,100 @@
-#ifndef MESH_H
-#define MESH_H
-
-#include <glad/glad.h> // holds all OpenGL type declarations
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-#include <learn_opengl/shader.h>
-
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <vector>
-using namespace std;
-
-struct Vertex {
-	glm::vec3 Position;
-	glm::vec3 Normal;
-	glm::vec2 TexCoords;
-};
-
-struct Texture {
-	unsigned int id;
-	string type;
-	string path;
-};
-
-class Mesh {
-public:
-	// Mesh Data
-	vector<Vertex> vertices;
-	vector<unsigned int> indices;
-	vector<Texture> textures;
-	unsigned int VAO;
-	// Functions
-	Mesh(vector<Vertex> &vertices, vector<unsigned int> &indices, vector<Texture> &textures)
-	{
-		this->vertices = vertices;
-		this->indices = indices;
-		this->textures = textures;
-
-		setupMesh();
-	}
-
-	void Draw(Shader shader)
-	{
-		unsigned int diffuseNr = 1;
-		unsigned int specularNr = 1;
-		for (unsigned int i = 0; i < textures.size(); i++)
-		{
-			glActiveTexture(GL_TEXTURE0 + i); // activate proper texture unit before binding
-			// retrieve texture number (the N in diffuse_textureN)
-			string number;
-			string name = textures[i].type;
-			if (name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if (name == "texture_specular")
-				number = std::to_string(specularNr++);
-
-			shader.setFloat(("material." + name + number).c_str(), i);
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
-		}
-		glActiveTexture(GL_TEXTURE0);
-
-		// draw mesh
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
-	}
-
-private:
-	// Data for rendering
-	unsigned int VBO, EBO;
-	// Functions
-	void setupMesh()
-	{
-		glGenVertexArrays(1, &VAO);
-		glBindVertexArray(VAO);
-
-		glGenBuffers(1, &VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-		glGenBuffers(1, &EBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-		// Vertex positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		// Vertex normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-		// vertex texture coords
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-		// vertex tangent
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-		glBindVertexArray(0);
-	}
-};
-
-#endif#pragma once
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h> // holds all OpenGL type declarations
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learn_opengl/shader.h>
+
+#include "profile.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec2 TexCoords;
+};
+
+struct Texture {
+	unsigned int id;
+	string type;
+	string path;
+};
+
+class Mesh {
+public:
+	// Mesh Data. Vertices and indices live in a MeshArena
+	vector<Texture> textures;
+	unsigned int numIndices;
+	unsigned int firstIndex; // Where the mesh's indices start in the arena's index buffer
+	unsigned int baseVertex; // Added to each index to find its vertex in the arena's vertex buffer
+	// Functions
+	Mesh(unsigned int baseVertex, unsigned int firstIndex, unsigned int numIndices, const vector<Texture> &textures)
+		: textures(textures), numIndices(numIndices), firstIndex(firstIndex), baseVertex(baseVertex)
+	{
+		setupSamplerNames();
+	}
+
+	// Draw count copies of the mesh in one call, each taking its model matrix from the instance buffer
+	// Needs the vertex array from MeshArena::createVertexArray bound
+	void DrawInstanced(const Shader &shader, unsigned int count)
+	{
+		bindTextures(shader);
+
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(unsigned int)), count, baseVertex);
+		PROFILE_COUNT(COUNTER_DRAW_CALLS, 1);
+	}
+
+private:
+	// Sampler uniform name for each texture ("material." + type + N), and its location in samplerProgram
+	vector<string> samplerNames;
+	vector<GLint> samplerLocations;
+	unsigned int samplerProgram = 0;
+	// Functions
+	void bindTextures(const Shader &shader)
+	{
+		// Locations only need looking up again when drawn with a different program
+		if (shader.ID != samplerProgram)
+		{
+			samplerProgram = shader.ID;
+			for (unsigned int i = 0; i < textures.size(); i++)
+				samplerLocations[i] = glGetUniformLocation(shader.ID, samplerNames[i].c_str());
+		}
+
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + i); // activate proper texture unit before binding
+			glUniform1i(samplerLocations[i], i);
+			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	void setupSamplerNames()
+	{
+		unsigned int diffuseNr = 1;
+		unsigned int specularNr = 1;
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			// retrieve texture number (the N in diffuse_textureN)
+			string number;
+			string name = textures[i].type;
+			if (name == "texture_diffuse")
+				number = std::to_string(diffuseNr++);
+			else if (name == "texture_specular")
+				number = std::to_string(specularNr++);
+			samplerNames.push_back("material." + name + number);
+		}
+		samplerLocations.assign(textures.size(), -1);
+	}
+};
+
+#endif#pragma once
@@ -0,0 +1,135 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "mesh.h"
+
+// One vertex buffer and one index buffer that every model's meshes are suballocated from
+// Each model still gets its own vertex array object, since that's where its instance buffer is attached, but they all
+// read the same two buffers, so meshes draw with glDrawElementsBaseVertex and only textures change between them
+class MeshArena
+{
+public:
+	enum : unsigned int { MIN_CAPACITY = 4096 }; // Vertices or indices allocated the first time round
+
+	struct Range
+	{
+		unsigned int baseVertex; // Added to each of the mesh's indices to find its vertex
+		unsigned int firstIndex;
+	};
+
+	// Append a mesh, growing the buffers if it doesn't fit. indices stay relative to the mesh's own vertices
+	Range add(const Vertex *vertices, unsigned int numVertices, const unsigned int *indices, unsigned int numIndices)
+	{
+		reserve(usedVertices + numVertices, usedIndices + numIndices);
+
+		// Uploads go through the copy target so no vertex array's element buffer binding gets disturbed
+		glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)usedVertices * sizeof(Vertex), (size_t)numVertices * sizeof(Vertex), vertices);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)usedIndices * sizeof(unsigned int), (size_t)numIndices * sizeof(unsigned int), indices);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		Range range = { usedVertices, usedIndices };
+		usedVertices += numVertices;
+		usedIndices += numIndices;
+		return range;
+	}
+
+	// Vertex array reading vertices and indices from the arena, and a glm::mat4 per instance from instanceVBO into
+	// attributes 3-6 (one column each)
+	unsigned int createVertexArray(unsigned int instanceVBO)
+	{
+		unsigned int VAO;
+		glGenVertexArrays(1, &VAO);
+		glBindVertexArray(VAO);
+		attachBuffers();
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(3 + i);
+			glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+			glVertexAttribDivisor(3 + i, 1);
+		}
+		glBindVertexArray(0);
+
+		vertexArrays.push_back(VAO);
+		return VAO;
+	}
+
+	unsigned int numVertices() const { return usedVertices; }
+	unsigned int numIndices() const { return usedIndices; }
+
+private:
+	unsigned int VBO = 0, EBO = 0;
+	unsigned int vertexCapacity = 0, indexCapacity = 0;
+	unsigned int usedVertices = 0, usedIndices = 0;
+	std::vector<unsigned int> vertexArrays; // Every one handed out, to be pointed at new buffers when they grow
+
+	void reserve(unsigned int numVertices, unsigned int numIndices)
+	{
+		if (numVertices <= vertexCapacity && numIndices <= indexCapacity)
+			return;
+		grow(VBO, vertexCapacity, usedVertices, numVertices, sizeof(Vertex));
+		grow(EBO, indexCapacity, usedIndices, numIndices, sizeof(unsigned int));
+
+		// Vertex arrays keep hold of the buffers they were set up with
+		for (unsigned int i = 0; i < vertexArrays.size(); i++)
+		{
+			glBindVertexArray(vertexArrays[i]);
+			attachBuffers();
+		}
+		glBindVertexArray(0);
+	}
+
+	// Move buffer to new storage for at least needed items (doubling, so appends stay amortised constant), copying the
+	// used part across on the GPU
+	static void grow(unsigned int &buffer, unsigned int &capacity, unsigned int used, unsigned int needed, size_t itemSize)
+	{
+		if (needed <= capacity)
+			return;
+		unsigned int newCapacity = std::max(needed, std::max(2 * capacity, (unsigned int)MIN_CAPACITY));
+		unsigned int newBuffer;
+		glGenBuffers(1, &newBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * itemSize, NULL, GL_STATIC_DRAW);
+		if (buffer != 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used * itemSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glDeleteBuffers(1, &buffer);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		buffer = newBuffer;
+		capacity = newCapacity;
+	}
+
+	// Vertex attributes 0-2 and the element buffer of whichever vertex array is bound
+	// Left for the first reserve if nothing has been allocated yet, core profiles reject offsets into buffer 0
+	void attachBuffers()
+	{
+		if (VBO == 0)
+			return;
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		// Vertex positions
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		// Vertex normals
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		// vertex texture coords
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	}
+};
+
+#endif
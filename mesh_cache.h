@@ -0,0 +1,211 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "hash.h"
+#include "mapped_file.h"
+#include "mesh.h"
+
+// Baked model file, so a model only goes through Assimp when its source files change
+// Layout, all in native byte order:
+//   MeshCacheHeader
+//   MeshCacheEntry   one per mesh
+//   vertices         numVertices Vertex then numIndices unsigned ints, for each mesh in turn
+//   textures         for each texture of each mesh: type length and path length (unsigned ints), then the characters
+// The vertex and index blobs stay 4 byte aligned, so they go to glBufferData straight out of the mapping
+struct MeshCacheHeader
+{
+	char magic[4];                 // "MSHC"
+	unsigned int version;
+	unsigned int vertexSize;       // sizeof(Vertex) it was written with
+	unsigned int numMeshes;
+	unsigned long long sourceHash; // hashModelSources of the files it was baked from
+};
+
+struct MeshCacheEntry
+{
+	unsigned int numVertices;
+	unsigned int numIndices;
+	unsigned int numTextures;
+};
+
+enum : unsigned int { MESH_CACHE_VERSION = 2 }; // 2: vertices welded and reordered when baked
+
+// A mesh as read from the source file, before it's uploaded. Textures only have their type and path
+struct BakedMesh
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Texture> textures;
+};
+
+// A mesh inside a mapped cache file, the pointers are only valid while the file stays mapped
+struct MappedMesh
+{
+	const Vertex *vertices;
+	unsigned int numVertices;
+	const unsigned int *indices;
+	unsigned int numIndices;
+	std::vector<Texture> textures;
+};
+
+// Renumber vertices in the order the indices first use them, so drawing walks the vertex buffer front to back rather
+// than jumping about. Vertices no index uses are dropped
+inline void optimizeVertexFetch(BakedMesh &mesh)
+{
+	const unsigned int UNUSED = 0xFFFFFFFFu;
+	std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+	std::vector<Vertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (unsigned int i = 0; i < mesh.indices.size(); i++)
+	{
+		unsigned int &to = remap[mesh.indices[i]];
+		if (to == UNUSED)
+		{
+			to = vertices.size();
+			vertices.push_back(mesh.vertices[mesh.indices[i]]);
+		}
+		mesh.indices[i] = to;
+	}
+	mesh.vertices.swap(vertices);
+}
+
+// Hash of a model file plus, for OBJ files, the material libraries it names, since texture paths live in those
+inline bool hashModelSources(const std::string &path, unsigned long long &hash)
+{
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+	hash = FNV_OFFSET_BASIS;
+	hashBytes(hash, file.data(), file.size());
+
+	std::string directory = path.substr(0, path.find_last_of('/'));
+	const char *text = reinterpret_cast<const char *>(file.data());
+	size_t size = file.size();
+	for (size_t line = 0; line < size;)
+	{
+		const char *end = static_cast<const char *>(memchr(text + line, '\n', size - line));
+		size_t lineEnd = end ? end - text : size;
+		if (lineEnd - line > 7 && memcmp(text + line, "mtllib ", 7) == 0)
+		{
+			std::string name(text + line + 7, lineEnd - line - 7);
+			while (!name.empty() && (name.back() == '\r' || name.back() == ' '))
+				name.pop_back();
+			MappedFile library;
+			if (library.open(directory + '/' + name))
+				hashBytes(hash, library.data(), library.size());
+		}
+		line = lineEnd + 1;
+	}
+	return true;
+}
+
+inline bool saveMeshCache(const std::string &fileName, unsigned long long sourceHash, const std::vector<BakedMesh> &meshes)
+{
+	std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	MeshCacheHeader header;
+	memcpy(header.magic, "MSHC", 4);
+	header.version = MESH_CACHE_VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.numMeshes = meshes.size();
+	header.sourceHash = sourceHash;
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	for (unsigned int m = 0; m < meshes.size(); m++)
+	{
+		MeshCacheEntry entry = { (unsigned int)meshes[m].vertices.size(), (unsigned int)meshes[m].indices.size(), (unsigned int)meshes[m].textures.size() };
+		file.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+	}
+	for (unsigned int m = 0; m < meshes.size(); m++)
+	{
+		file.write(reinterpret_cast<const char *>(meshes[m].vertices.data()), meshes[m].vertices.size() * sizeof(Vertex));
+		file.write(reinterpret_cast<const char *>(meshes[m].indices.data()), meshes[m].indices.size() * sizeof(unsigned int));
+	}
+	for (unsigned int m = 0; m < meshes.size(); m++)
+	{
+		for (unsigned int t = 0; t < meshes[m].textures.size(); t++)
+		{
+			const Texture &texture = meshes[m].textures[t];
+			unsigned int lengths[2] = { (unsigned int)texture.type.size(), (unsigned int)texture.path.size() };
+			file.write(reinterpret_cast<const char *>(lengths), sizeof(lengths));
+			file.write(texture.type.data(), texture.type.size());
+			file.write(texture.path.data(), texture.path.size());
+		}
+	}
+	return file.good();
+}
+
+// Map fileName and point meshes into it. file has to stay open while they're used
+// Returns false if the file is missing, malformed or was baked from other sources
+inline bool loadMeshCache(MappedFile &file, const std::string &fileName, unsigned long long sourceHash, std::vector<MappedMesh> &meshes)
+{
+	if (!file.open(fileName) || file.size() < sizeof(MeshCacheHeader))
+		return false;
+
+	MeshCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, "MSHC", 4) != 0 || header.version != MESH_CACHE_VERSION || header.vertexSize != sizeof(Vertex))
+		return false;
+	if (header.sourceHash != sourceHash)
+		return false;
+
+	const unsigned char *at = file.data() + sizeof(header);
+	const unsigned char *end = file.data() + file.size();
+	if ((size_t)(end - at) < (size_t)header.numMeshes * sizeof(MeshCacheEntry))
+		return false;
+	std::vector<MeshCacheEntry> entries(header.numMeshes);
+	if (header.numMeshes > 0)
+		memcpy(entries.data(), at, header.numMeshes * sizeof(MeshCacheEntry));
+	at += header.numMeshes * sizeof(MeshCacheEntry);
+
+	meshes.assign(header.numMeshes, MappedMesh());
+	for (unsigned int m = 0; m < header.numMeshes; m++)
+	{
+		size_t bytes = (size_t)entries[m].numVertices * sizeof(Vertex) + (size_t)entries[m].numIndices * sizeof(unsigned int);
+		if ((size_t)(end - at) < bytes)
+			return false;
+		meshes[m].vertices = reinterpret_cast<const Vertex *>(at);
+		meshes[m].numVertices = entries[m].numVertices;
+		at += (size_t)entries[m].numVertices * sizeof(Vertex);
+		meshes[m].indices = reinterpret_cast<const unsigned int *>(at);
+		meshes[m].numIndices = entries[m].numIndices;
+		at += (size_t)entries[m].numIndices * sizeof(unsigned int);
+
+		// Don't trust indices that would read past the vertices
+		for (unsigned int i = 0; i < meshes[m].numIndices; i++)
+		{
+			if (meshes[m].indices[i] >= meshes[m].numVertices)
+				return false;
+		}
+	}
+
+	for (unsigned int m = 0; m < header.numMeshes; m++)
+	{
+		for (unsigned int t = 0; t < entries[m].numTextures; t++)
+		{
+			unsigned int lengths[2];
+			if ((size_t)(end - at) < sizeof(lengths))
+				return false;
+			memcpy(lengths, at, sizeof(lengths));
+			at += sizeof(lengths);
+			if ((size_t)(end - at) < (size_t)lengths[0] + lengths[1])
+				return false;
+			Texture texture;
+			texture.id = 0;
+			texture.type.assign(reinterpret_cast<const char *>(at), lengths[0]);
+			texture.path.assign(reinterpret_cast<const char *>(at) + lengths[0], lengths[1]);
+			at += (size_t)lengths[0] + lengths[1];
+			meshes[m].textures.push_back(texture);
+		}
+	}
+	return at == end;
+}
+
+#endif
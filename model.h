@@ -1,208 +1,216 @@
-#ifndef MODEL_H
-#define MODEL_H
-
-#include <glad/glad.h> 
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
-#include "mesh.h"
-#include <learn_opengl/shader.h>
-
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <map>
-#include <vector>
-
-#include <stb/stb_image.h>
-
-using namespace std;
-
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
-
-class Model
-{
-public:
-	/*  Functions   */
-	Model(string path)
-	{
-		loadModel(path);
-	}
-	void Draw(Shader shader)
-	{
-		for (unsigned int i = 0; i < meshes.size(); i++)
-			meshes[i].Draw(shader);
-	}
-private:
-	/*  Model Data  */
-	vector<Mesh> meshes;
-	vector<Texture> textures_loaded;
-	string directory;
-	/*  Functions   */
-	void loadModel(string path)
-	{
-		Assimp::Importer import;
-		const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs); // | aiProcess_JoinIdenticalVertices?
-
-		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-		{
-			cout << "ERROR::ASSIMP::" << import.GetErrorString() << endl;
-			return;
-		}
-		directory = path.substr(0, path.find_last_of('/'));
-
-		processNode(scene->mRootNode, scene);
-	}
-
-	void processNode(aiNode *node, const aiScene *scene)
-	{
-		// process all the node's meshes (if any)
-		for (unsigned int i = 0; i < node->mNumMeshes; i++)
-		{
-			aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes.push_back(processMesh(mesh, scene));
-		}
-		// then do the same for each of its children
-		for (unsigned int i = 0; i < node->mNumChildren; i++)
-		{
-			processNode(node->mChildren[i], scene);
-		}
-	}
-
-	Mesh processMesh(aiMesh *mesh, const aiScene *scene)
-	{
-		vector<Vertex> vertices;
-		vector<unsigned int> indices;
-		vector<Texture> textures;
-
-		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-		{
-			Vertex vertex;
-			// process vertex positions, normals and texture coordinates
-			glm::vec3 vector;
-			// position
-			vector.x = mesh->mVertices[i].x;
-			vector.y = mesh->mVertices[i].y;
-			vector.z = mesh->mVertices[i].z;
-			vertex.Position = vector;
-			// normals
-			vector.x = mesh->mNormals[i].x;
-			vector.y = mesh->mNormals[i].y;
-			vector.z = mesh->mNormals[i].z;
-			vertex.Normal = vector;
-			// tex coords
-			if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
-			{
-				glm::vec2 vec;
-				vec.x = mesh->mTextureCoords[0][i].x;
-				vec.y = mesh->mTextureCoords[0][i].y;
-				vertex.TexCoords = vec;
-			}
-			else
-				vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-			vertices.push_back(vertex);
-		}
-
-		// process indices
-		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-		{
-			aiFace face = mesh->mFaces[i];
-			for (unsigned int j = 0; j < face.mNumIndices; j++)
-				indices.push_back(face.mIndices[j]);
-		}
-
-		// process material
-		if (mesh->mMaterialIndex >= 0)
-		{
-			aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
-			
-			vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-			textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-			
-			vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-			textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-		}
-
-		return Mesh(vertices, indices, textures);
-	}
-
-	vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
-	{
-		vector<Texture> textures;
-		for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
-		{
-			aiString str;
-			mat->GetTexture(type, i, &str);
-			Texture texture;
-			bool skip = false;
-			for (unsigned int j = 0; j < textures_loaded.size(); j++)
-			{
-				if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-				{
-					textures.push_back(textures_loaded[j]);
-					skip = true;
-					break;
-				}
-			}
-
-			if (!skip)
-			{
-				texture.id = TextureFromFile(str.C_Str(), directory);
-				texture.type = typeName;
-				texture.path = str.C_Str();
-				textures.push_back(texture);
-				textures_loaded.push_back(texture);
-			}
-		}
-		return textures;
-	}
-};
-
-
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
-{
-	string filename = string(path);
-	filename = directory + '/' + filename;
-
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
-}
-
+#ifndef MODEL_H
+#define MODEL_H
+
+#include <glad/glad.h> 
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "mesh.h"
+#include "mesh_arena.h"
+#include "mesh_cache.h"
+#include "texture_loader.h"
+#include <learn_opengl/shader.h>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+class Model
+{
+public:
+	/*  Functions   */
+	// Textures are only requested from textureLoader, they're filled in by its next finish()
+	// Vertices and indices go into arena, which has to outlive the model
+	Model(string path, TextureLoader &textureLoader, MeshArena &arena)
+	{
+		// Every mesh reads its model matrices from the same per model buffer, through the model's one vertex array
+		glGenBuffers(1, &instanceVBO);
+		VAO = arena.createVertexArray(instanceVBO);
+
+		loadModel(path, textureLoader, arena);
+	}
+	// Draw one copy of the model per matrix, with one draw call per mesh however many copies there are
+	// Needs a shader that takes the model matrix from attributes 3-6 rather than a uniform
+	void DrawInstanced(const Shader &shader, const vector<glm::mat4> &instances)
+	{
+		if (instances.empty())
+			return;
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		if (instances.size() > instanceCapacity)
+			instanceCapacity = std::max(instances.size(), 2 * instanceCapacity);
+		// Orphan last frame's storage so the upload doesn't wait on draws still reading it
+		glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::mat4), instances.data());
+
+		glBindVertexArray(VAO);
+		for (unsigned int i = 0; i < meshes.size(); i++)
+			meshes[i].DrawInstanced(shader, instances.size());
+		glBindVertexArray(0);
+	}
+private:
+	/*  Model Data  */
+	vector<Mesh> meshes;
+	string directory;
+	unsigned int VAO = 0;
+	unsigned int instanceVBO = 0;
+	size_t instanceCapacity = 0; // In matrices
+	/*  Functions   */
+	void loadModel(string path, TextureLoader &textureLoader, MeshArena &arena)
+	{
+		directory = path.substr(0, path.find_last_of('/'));
+
+		// Use the baked copy next to the model if it was made from the same source files, so Assimp only runs after an edit
+		string cacheName = path + ".meshcache";
+		unsigned long long sourceHash = 0;
+		bool hashed = hashModelSources(path, sourceHash);
+		if (hashed)
+		{
+			MappedFile cache;
+			vector<MappedMesh> cached;
+			if (loadMeshCache(cache, cacheName, sourceHash, cached))
+			{
+				meshes.reserve(cached.size());
+				for (unsigned int i = 0; i < cached.size(); i++)
+				{
+					const MappedMesh &mesh = cached[i];
+					MeshArena::Range range = arena.add(mesh.vertices, mesh.numVertices, mesh.indices, mesh.numIndices);
+					meshes.push_back(Mesh(range.baseVertex, range.firstIndex, mesh.numIndices, loadTextures(mesh.textures, textureLoader)));
+				}
+				return;
+			}
+		}
+
+		Assimp::Importer import;
+		// Weld corners that share every attribute, then order triangles to reuse the post transform cache
+		const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices
+			| aiProcess_ImproveCacheLocality);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			cout << "ERROR::ASSIMP::" << import.GetErrorString() << endl;
+			return;
+		}
+
+		vector<BakedMesh> baked;
+		processNode(scene->mRootNode, scene, baked);
+		for (unsigned int i = 0; i < baked.size(); i++)
+			optimizeVertexFetch(baked[i]);
+		if (hashed && !saveMeshCache(cacheName, sourceHash, baked))
+			cout << "Couldn't write mesh cache " << cacheName << endl;
+
+		meshes.reserve(baked.size());
+		for (unsigned int i = 0; i < baked.size(); i++)
+		{
+			const BakedMesh &mesh = baked[i];
+			MeshArena::Range range = arena.add(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+			meshes.push_back(Mesh(range.baseVertex, range.firstIndex, mesh.indices.size(), loadTextures(mesh.textures, textureLoader)));
+		}
+	}
+
+	void processNode(aiNode *node, const aiScene *scene, vector<BakedMesh> &baked)
+	{
+		// process all the node's meshes (if any)
+		for (unsigned int i = 0; i < node->mNumMeshes; i++)
+		{
+			aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+			baked.push_back(BakedMesh());
+			processMesh(mesh, scene, baked.back());
+		}
+		// then do the same for each of its children
+		for (unsigned int i = 0; i < node->mNumChildren; i++)
+		{
+			processNode(node->mChildren[i], scene, baked);
+		}
+	}
+
+	// Fills out in place, so the vertex and index arrays are built once and never copied
+	void processMesh(aiMesh *mesh, const aiScene *scene, BakedMesh &out)
+	{
+		vector<Vertex> &vertices = out.vertices;
+		vector<unsigned int> &indices = out.indices;
+		vertices.reserve(mesh->mNumVertices);
+		indices.reserve(mesh->mNumFaces * 3);
+
+		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+		{
+			Vertex vertex;
+			// process vertex positions, normals and texture coordinates
+			glm::vec3 vector;
+			// position
+			vector.x = mesh->mVertices[i].x;
+			vector.y = mesh->mVertices[i].y;
+			vector.z = mesh->mVertices[i].z;
+			vertex.Position = vector;
+			// normals
+			vector.x = mesh->mNormals[i].x;
+			vector.y = mesh->mNormals[i].y;
+			vector.z = mesh->mNormals[i].z;
+			vertex.Normal = vector;
+			// tex coords
+			if (mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+			{
+				glm::vec2 vec;
+				vec.x = mesh->mTextureCoords[0][i].x;
+				vec.y = mesh->mTextureCoords[0][i].y;
+				vertex.TexCoords = vec;
+			}
+			else
+				vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+
+			vertices.push_back(vertex);
+		}
+
+		// process indices
+		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+		{
+			const aiFace &face = mesh->mFaces[i];
+			for (unsigned int j = 0; j < face.mNumIndices; j++)
+				indices.push_back(face.mIndices[j]);
+		}
+
+		// process material
+		if (mesh->mMaterialIndex >= 0)
+		{
+			aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+			materialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", out.textures);
+			materialTextures(material, aiTextureType_SPECULAR, "texture_specular", out.textures);
+		}
+	}
+
+	// Add the type and path of each of the material's textures of the given type, without loading them
+	void materialTextures(aiMaterial *mat, aiTextureType type, const string &typeName, vector<Texture> &textures)
+	{
+		for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+		{
+			aiString str;
+			mat->GetTexture(type, i, &str);
+			Texture texture;
+			texture.id = 0;
+			texture.type = typeName;
+			texture.path = str.C_Str();
+			textures.push_back(texture);
+		}
+	}
+
+	// Textures named in refs, relative to the model. The loader shares any file that's already been asked for
+	vector<Texture> loadTextures(const vector<Texture> &refs, TextureLoader &textureLoader)
+	{
+		vector<Texture> textures = refs;
+		for (unsigned int i = 0; i < textures.size(); i++)
+			textures[i].id = textureLoader.request(directory + '/' + textures[i].path);
+		return textures;
+	}
+};
+
 #endif
\ No newline at end of file
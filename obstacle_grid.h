@@ -0,0 +1,167 @@
+#ifndef OBSTACLE_GRID_H
+#define OBSTACLE_GRID_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Broad phase for segment vs obstacle tests
+// Each obstacle's bounding box is registered in every cell of a uniform grid it overlaps, and a segment query walks
+// only the cells the segment passes through (Amanatides & Woo traversal)
+class ObstacleGrid
+{
+public:
+	struct Box
+	{
+		glm::vec2 min, max;
+	};
+
+	// Throw away the current grid and bucket all boxes, ids[i] is what queries report for boxes[i]
+	void build(const std::vector<Box> &boxes, const std::vector<unsigned int> &ids)
+	{
+		cells.clear();
+		numBoxes = 0;
+		if (boxes.empty())
+		{
+			nx = nz = 0;
+			return;
+		}
+
+		glm::vec2 lo = boxes[0].min, hi = boxes[0].max;
+		float totalSize = 0.0f;
+		for (unsigned int i = 0; i < boxes.size(); i++)
+		{
+			lo = glm::min(lo, boxes[i].min);
+			hi = glm::max(hi, boxes[i].max);
+			totalSize += std::max(boxes[i].max[0] - boxes[i].min[0], boxes[i].max[1] - boxes[i].min[1]);
+		}
+
+		// Leave room around the current obstacles so new ones nearby don't force a rebuild
+		glm::vec2 pad = (hi - lo) * 0.25f + glm::vec2(1.0f);
+		origin = lo - pad;
+		glm::vec2 extent = hi + pad - origin;
+
+		// Cells about the size of an obstacle, but no more cells than a few per obstacle
+		float averageSize = totalSize / boxes.size();
+		cellSize = std::max(averageSize, std::sqrt(extent[0] * extent[1] / (4.0f * boxes.size())));
+		nx = std::max(1, (int)std::ceil(extent[0] / cellSize));
+		nz = std::max(1, (int)std::ceil(extent[1] / cellSize));
+		cells.resize(nx * nz);
+
+		builtWith = boxes.size();
+		for (unsigned int i = 0; i < boxes.size(); i++)
+			insert(ids[i], boxes[i]);
+	}
+
+	// Add one more box, returns false if the grid needs a rebuild instead (box outside bounds or grid overfull)
+	bool insert(unsigned int id, const Box &box)
+	{
+		if (nx == 0 || numBoxes >= 2 * builtWith + 16)
+			return false;
+		if (box.min[0] < origin[0] || box.min[1] < origin[1] || box.max[0] > origin[0] + nx * cellSize || box.max[1] > origin[1] + nz * cellSize)
+			return false;
+
+		int x0 = cellX(box.min[0]), x1 = cellX(box.max[0]);
+		int z0 = cellZ(box.min[1]), z1 = cellZ(box.max[1]);
+		for (int z = z0; z <= z1; z++)
+			for (int x = x0; x <= x1; x++)
+				cells[z * nx + x].push_back(id);
+		numBoxes++;
+		return true;
+	}
+
+	// Call test(id) for boxes in each cell the segment from a to b crosses, stopping as soon as one returns true
+	// Ids can be passed more than once if a box spans several cells on the segment
+	template <typename F>
+	bool anyAlongSegment(glm::vec2 a, glm::vec2 b, F test) const
+	{
+		if (nx == 0)
+			return false;
+
+		// Clip the segment to the grid, nothing outside can hit a box
+		glm::vec2 d = b - a;
+		float tEnter = 0.0f, tExit = 1.0f;
+		glm::vec2 hi = origin + glm::vec2(nx * cellSize, nz * cellSize);
+		for (int axis = 0; axis < 2; axis++)
+		{
+			if (d[axis] == 0.0f)
+			{
+				if (a[axis] < origin[axis] || a[axis] > hi[axis])
+					return false;
+			}
+			else
+			{
+				float t0 = (origin[axis] - a[axis]) / d[axis];
+				float t1 = (hi[axis] - a[axis]) / d[axis];
+				if (t0 > t1)
+					std::swap(t0, t1);
+				tEnter = std::max(tEnter, t0);
+				tExit = std::min(tExit, t1);
+			}
+		}
+		if (tEnter > tExit)
+			return false;
+
+		glm::vec2 p = a + d * tEnter;
+		glm::vec2 q = a + d * tExit;
+		int x = cellX(p[0]), z = cellZ(p[1]);
+		int endX = cellX(q[0]), endZ = cellZ(q[1]);
+
+		int stepX = d[0] > 0.0f ? 1 : (d[0] < 0.0f ? -1 : 0);
+		int stepZ = d[1] > 0.0f ? 1 : (d[1] < 0.0f ? -1 : 0);
+		// Segment parameter at the next vertical/horizontal cell boundary, and between boundaries
+		float tMaxX = stepX != 0 ? (origin[0] + (x + (stepX > 0 ? 1 : 0)) * cellSize - a[0]) / d[0] : INFINITY;
+		float tMaxZ = stepZ != 0 ? (origin[1] + (z + (stepZ > 0 ? 1 : 0)) * cellSize - a[1]) / d[1] : INFINITY;
+		float tDeltaX = stepX != 0 ? cellSize / std::fabs(d[0]) : INFINITY;
+		float tDeltaZ = stepZ != 0 ? cellSize / std::fabs(d[1]) : INFINITY;
+
+		int maxCells = nx + nz + 2;
+		for (int visited = 0; visited < maxCells; visited++)
+		{
+			const std::vector<unsigned int> &cell = cells[z * nx + x];
+			for (unsigned int k = 0; k < cell.size(); k++)
+			{
+				if (test(cell[k]))
+					return true;
+			}
+
+			if (x == endX && z == endZ)
+				break;
+			if (tMaxX < tMaxZ)
+			{
+				x += stepX;
+				tMaxX += tDeltaX;
+			}
+			else
+			{
+				z += stepZ;
+				tMaxZ += tDeltaZ;
+			}
+			if (x < 0 || x >= nx || z < 0 || z >= nz)
+				break;
+		}
+		return false;
+	}
+
+private:
+	glm::vec2 origin = glm::vec2(0.0f);
+	float cellSize = 1.0f;
+	int nx = 0, nz = 0;
+	unsigned int numBoxes = 0;
+	unsigned int builtWith = 0;
+	std::vector<std::vector<unsigned int>> cells; // Box ids overlapping each cell, row major
+
+	int cellX(float x) const
+	{
+		return std::min(nx - 1, std::max(0, (int)std::floor((x - origin[0]) / cellSize)));
+	}
+
+	int cellZ(float z) const
+	{
+		return std::min(nz - 1, std::max(0, (int)std::floor((z - origin[1]) / cellSize)));
+	}
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "hash.h"
+#include "obstacle_grid.h"
+
+inline bool lineIntersection(glm::vec2 p1, glm::vec2 p2, glm::vec2 q1, glm::vec2 q2);
+
+// Static obstacles on the ground plane: round barrels and rectangular cars
+// Sizes used for collision are grown by the agent radius so agents can be treated as points
+// Add obstacles through addBarrel/addCar so the broad phase grid stays in sync
+class ObstacleSet
+{
+public:
+	float agentRad = 0.49f;
+	float barrelRad = 1.0f;
+	float carLength = 2.5f;
+	float carWidth = 1.25f;
+
+	// Barrels
+	std::vector<glm::vec3> barrelPos;
+	float barrelRadCoord;
+
+	// Cars
+	std::vector<glm::vec3> carPos;
+	std::vector<bool> carRot;
+	float carX;
+	float carZ;
+
+	ObstacleSet()
+	{
+		updateClearance();
+	}
+
+	// Call after changing agentRad or any obstacle size
+	void updateClearance()
+	{
+		barrelRadCoord = barrelRad + agentRad;
+		carX = carLength + agentRad;
+		carZ = carWidth + agentRad;
+		rebuildGrid();
+	}
+
+	void addBarrel(glm::vec3 pos)
+	{
+		barrelPos.push_back(pos);
+		unsigned int id = barrelPos.size() - 1;
+		if (!grid.insert(id, barrelBox(id)))
+			rebuildGrid();
+	}
+
+	void addCar(glm::vec3 pos, bool rotated)
+	{
+		carPos.push_back(pos);
+		carRot.push_back(rotated);
+		unsigned int id = carPos.size() - 1;
+		if (!grid.insert(CAR_ID | id, carBox(id)))
+			rebuildGrid();
+	}
+
+	// Re-bucket every obstacle, needed if barrelPos/carPos were changed directly
+	void rebuildGrid()
+	{
+		std::vector<ObstacleGrid::Box> boxes;
+		std::vector<unsigned int> ids;
+		for (unsigned int k = 0; k < barrelPos.size(); k++)
+		{
+			boxes.push_back(barrelBox(k));
+			ids.push_back(k);
+		}
+		for (unsigned int k = 0; k < carPos.size(); k++)
+		{
+			boxes.push_back(carBox(k));
+			ids.push_back(CAR_ID | k);
+		}
+		grid.build(boxes, ids);
+	}
+
+	// Hash of every obstacle and size, for telling whether anything built around the obstacles is still valid
+	unsigned long long hash() const
+	{
+		unsigned long long h = FNV_OFFSET_BASIS;
+		hashBytes(h, &agentRad, sizeof(float));
+		hashBytes(h, &barrelRad, sizeof(float));
+		hashBytes(h, &carLength, sizeof(float));
+		hashBytes(h, &carWidth, sizeof(float));
+		unsigned int counts[2] = { (unsigned int)barrelPos.size(), (unsigned int)carPos.size() };
+		hashBytes(h, counts, sizeof(counts));
+		if (!barrelPos.empty())
+			hashBytes(h, barrelPos.data(), barrelPos.size() * sizeof(glm::vec3));
+		if (!carPos.empty())
+			hashBytes(h, carPos.data(), carPos.size() * sizeof(glm::vec3));
+		for (unsigned int k = 0; k < carRot.size(); k++)
+		{
+			unsigned char rotated = carRot[k];
+			hashBytes(h, &rotated, 1);
+		}
+		return h;
+	}
+
+	// Returns true if the segment between the two points is blocked
+	// Only obstacles in grid cells along the segment get the exact test
+	bool collidesWithObs(glm::vec2 point1, glm::vec2 point2) const
+	{
+		return grid.anyAlongSegment(point1, point2, [&](unsigned int id)
+		{
+			if (id & CAR_ID)
+				return segmentHitsCar(point1, point2, id & ~CAR_ID);
+			return segmentHitsBarrel(point1, point2, id);
+		});
+	}
+
+	// Same as collidesWithObs but tests every obstacle, for checking and benchmarking the grid
+	bool collidesWithObsLinear(glm::vec2 point1, glm::vec2 point2) const
+	{
+		// Check for barrels
+		for (unsigned int k = 0; k < barrelPos.size(); k++)
+		{
+			if (segmentHitsBarrel(point1, point2, k))
+				return true;
+		}
+
+		// Check for cars
+		for (unsigned int k = 0; k < carPos.size(); k++)
+		{
+			if (segmentHitsCar(point1, point2, k))
+				return true;
+		}
+
+		// If we havent returned by now then there are no violations
+		return false;
+	}
+
+	bool segmentHitsBarrel(glm::vec2 point1, glm::vec2 point2, int k) const
+	{
+		glm::vec2 obsPos = glm::vec2(barrelPos[k][0], barrelPos[k][2]);
+
+		glm::vec2 line = point2 - point1;
+		glm::vec2 pointToObs = obsPos - point1;
+		float dot = glm::dot(pointToObs, glm::normalize(line));
+		glm::vec2 nearestPoint = point1 + glm::normalize(line) * dot;
+
+		bool point1InObs = glm::length(obsPos - point1) < barrelRadCoord;
+		bool point2InObs = glm::length(obsPos - point2) < barrelRadCoord;
+		bool onSegment = (dot > 0 && dot < glm::length(line));
+		bool inObs(glm::length(obsPos - nearestPoint) < barrelRadCoord);
+
+		return point1InObs || point2InObs || (onSegment && inObs);
+	}
+
+	bool segmentHitsCar(glm::vec2 point1, glm::vec2 point2, int k) const
+	{
+		// See if line between points crosses any edges of rectangle and if points lie within rectangle
+		bool p1inX = (point1[0] > carPos[k][0] - (carX / 2)) && (point1[0] < carPos[k][0] + (carX / 2));
+		bool p2inX = (point2[0] > carPos[k][0] - (carX / 2)) && (point2[0] < carPos[k][0] + (carX / 2));
+		bool p1inZ = (point1[1] > carPos[k][2] - (carZ / 2)) && (point1[1] < carPos[k][2] + (carZ / 2));
+		bool p2inZ = (point2[1] > carPos[k][2] - (carZ / 2)) && (point2[1] < carPos[k][2] + (carZ / 2));
+
+		bool inside = (p1inX && p1inZ && p2inX && p2inZ);
+		if (inside)
+			return true;
+
+		glm::vec2 c1 = glm::vec2(carPos[k][0], carPos[k][2]) + glm::vec2(-carX + agentRad / 2.0f, -carZ + agentRad / 2.0f);
+		glm::vec2 c2 = glm::vec2(carPos[k][0], carPos[k][2]) + glm::vec2(carX + agentRad / 2.0f, -carZ + agentRad / 2.0f);
+		glm::vec2 c3 = glm::vec2(carPos[k][0], carPos[k][2]) + glm::vec2(-carX + agentRad / 2.0f, carZ + agentRad / 2.0f);
+		glm::vec2 c4 = glm::vec2(carPos[k][0], carPos[k][2]) + glm::vec2(carX + agentRad / 2.0f, carZ + agentRad / 2.0f);
+		return lineIntersection(point1, point2, c1, c2) || lineIntersection(point1, point2, c1, c3)
+			|| lineIntersection(point1, point2, c4, c2) || lineIntersection(point1, point2, c4, c3);
+	}
+
+	// Bounds covering everything segmentHitsBarrel/segmentHitsCar can report, padded for rounding
+	ObstacleGrid::Box barrelBox(unsigned int k) const
+	{
+		glm::vec2 center = glm::vec2(barrelPos[k][0], barrelPos[k][2]);
+		glm::vec2 halfSize = glm::vec2(barrelRadCoord + 1e-3f);
+		ObstacleGrid::Box box = { center - halfSize, center + halfSize };
+		return box;
+	}
+
+	ObstacleGrid::Box carBox(unsigned int k) const
+	{
+		// The edge test uses corners offset by up to carX/carZ plus half the agent radius
+		glm::vec2 center = glm::vec2(carPos[k][0], carPos[k][2]);
+		glm::vec2 halfSize = glm::vec2(carX + agentRad, carZ + agentRad) + glm::vec2(1e-3f);
+		ObstacleGrid::Box box = { center - halfSize, center + halfSize };
+		return box;
+	}
+
+private:
+	enum : unsigned int { CAR_ID = 0x80000000u }; // Grid ids are barrel indices, or car indices with this bit set
+
+	ObstacleGrid grid;
+};
+
+inline bool ccw(glm::vec2 a, glm::vec2 b, glm::vec2 c) //Determines if a,b,c are counterclockwise rotated
+{
+	return (c[1] - a[1]) * (b[0] - a[0]) > (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+inline bool lineIntersection(glm::vec2 p1, glm::vec2 p2, glm::vec2 q1, glm::vec2 q2)
+{
+	return (ccw(p1, q1, q2) != ccw(p2, q1, q2)) && (ccw(p1, p2, q1) != ccw(p1, p2, q2));
+}
+
+#endif
@@ -0,0 +1,356 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "dstar_lite.h"
+#include "flow_field.h"
+#include "hash.h"
+#include "obstacles.h"
+#include "profile.h"
+#include "roadmap.h"
+#include "roadmap_cache.h"
+#include "simulation.h"
+#include "thread_pool.h"
+
+// Everything needed to plan and move the crowd, with no rendering
+// The windowed app and the headless runner both drive one of these
+class MotionPlanner
+{
+public:
+	ThreadPool pool; // Shared by roadmap construction and the crowd
+	ObstacleSet obstacles;
+	Roadmap roadmap;
+	CrowdSimulation crowd;
+
+	float mapSize = 40.0f;
+	int numNewPos = 150;
+	bool aStar = false;
+	bool incremental = false; // Keep a D* Lite search per agent so replanning after a change only repairs what it affects,
+	                          // at the cost of a few floats per roadmap node per agent
+	bool smoothPaths = true;  // Cut out waypoints an agent can skip in a straight line once a path is found
+	bool sharedGoals = false; // Plan with one flow field per distinct goal node that agents follow, rather than one
+	                          // search per agent, for crowds heading to a handful of destinations
+	std::string roadmapCache; // If set, buildRoadmap reuses the roadmap saved in this file when it was built for the same
+	                          // obstacles and settings, otherwise it builds one and saves it there
+	std::vector<unsigned int> startIndices; // Roadmap node each agent's current path starts from
+	std::vector<unsigned int> goalIndices;
+	std::vector<std::vector<unsigned int>> agentPaths; // Node indices of each agent's current path, goal first
+	std::vector<DStarLite> searches;                   // Each agent's search when incremental is set
+	std::vector<unsigned long long> removedEdges;      // Every edge dropped since the searches were started, searches
+	                                                   // catch up on these when they are next used
+	std::vector<FlowField> flowFields;                 // One per distinct goal node when sharedGoals is set
+	std::vector<unsigned int> agentFields;             // Index into flowFields for each agent
+
+	MotionPlanner(unsigned int numThreads = 0) : pool(numThreads), crowd(pool)
+	{
+		crowd.agentRad = obstacles.agentRad;
+	}
+
+	MotionPlanner(const MotionPlanner &) = delete;
+	MotionPlanner &operator=(const MotionPlanner &) = delete;
+
+	void addAgent(glm::vec3 start, glm::vec3 goal)
+	{
+		crowd.addAgent(start, goal);
+		goalIndices.push_back(0);
+		startIndices.push_back(0);
+		agentPaths.push_back(std::vector<unsigned int>());
+	}
+
+	// Add an obstacle, dropping the roadmap edges it blocks and replanning the agents that were going to use them
+	void addBarrel(glm::vec3 pos)
+	{
+		obstacles.addBarrel(pos);
+		unsigned int k = obstacles.barrelPos.size() - 1;
+		repairAround(obstacles.barrelBox(k), [this, k](glm::vec2 p1, glm::vec2 p2) { return obstacles.segmentHitsBarrel(p1, p2, k); });
+	}
+
+	void addCar(glm::vec3 pos, bool rotated)
+	{
+		obstacles.addCar(pos, rotated);
+		unsigned int k = obstacles.carPos.size() - 1;
+		repairAround(obstacles.carBox(k), [this, k](glm::vec2 p1, glm::vec2 p2) { return obstacles.segmentHitsCar(p1, p2, k); });
+	}
+
+	// Sample the roadmap (or load it from roadmapCache) and connect everything with line of sight, then add each agent's
+	// position and goal to it
+	void buildRoadmap(unsigned int seed)
+	{
+		PROFILE_SCOPE("buildRoadmap");
+		searches.clear();
+		removedEdges.clear();
+		unsigned long long obstacleHash = obstacles.hash();
+		if (roadmapCache.empty() || !loadRoadmapFile(roadmap, roadmapCache, obstacleHash, settingsHash()))
+		{
+			roadmap.clear();
+			/* initialize random seed: */
+			srand(seed);
+			roadmap.sample(numNewPos, mapSize);
+			roadmap.connect(obstacles, pool);
+			if (!roadmapCache.empty())
+				saveRoadmapFile(roadmap, roadmapCache, obstacleHash, settingsHash());
+		}
+
+		unsigned int firstAgentPoint = roadmap.numNodes();
+		for (unsigned int i = 0; i < crowd.numAgents(); i++)
+			startIndices[i] = roadmap.addPoint(crowd.position(i));
+
+		// Agents with the same goal share its node, so they can share a search too
+		std::vector<unsigned int> byGoal(crowd.numAgents());
+		for (unsigned int i = 0; i < byGoal.size(); i++)
+			byGoal[i] = i;
+		const std::vector<glm::vec3> &goals = crowd.goals();
+		std::sort(byGoal.begin(), byGoal.end(), [&goals](unsigned int a, unsigned int b)
+		{
+			return std::lexicographical_compare(&goals[a][0], &goals[a][0] + 3, &goals[b][0], &goals[b][0] + 3);
+		});
+		for (unsigned int k = 0; k < byGoal.size(); k++)
+		{
+			unsigned int i = byGoal[k];
+			if (k > 0 && goals[i] == goals[byGoal[k - 1]])
+				goalIndices[i] = goalIndices[byGoal[k - 1]];
+			else
+				goalIndices[i] = roadmap.addPoint(goals[i]);
+		}
+		roadmap.connect(obstacles, pool, firstAgentPoint);
+	}
+
+	// Everything besides the obstacles that decides what roadmap gets built
+	unsigned long long settingsHash() const
+	{
+		unsigned long long h = FNV_OFFSET_BASIS;
+		hashBytes(h, &numNewPos, sizeof(numNewPos));
+		hashBytes(h, &mapSize, sizeof(mapSize));
+		hashBytes(h, &roadmap.connection, sizeof(roadmap.connection));
+		hashBytes(h, &roadmap.connectK, sizeof(roadmap.connectK));
+		hashBytes(h, &roadmap.connectRadius, sizeof(roadmap.connectRadius));
+		hashBytes(h, &roadmap.lazy, sizeof(roadmap.lazy));
+		return h;
+	}
+
+	// Search the roadmap for every agent and hand the paths to the crowd
+	void planPaths()
+	{
+		PROFILE_SCOPE("planPaths");
+		searches.clear();
+		removedEdges.clear();
+		if (roadmap.lazy && (sharedGoals || incremental))
+			roadmap.checkEdges(obstacles, pool); // These search more of the roadmap than a path's worth of edges
+		if (sharedGoals)
+			buildFlowFields();
+		if (sharedGoals || incremental)
+		{
+			for (unsigned int agent = 0; agent < crowd.numAgents(); agent++)
+				planPath(agent);
+			return;
+		}
+
+		//A*, every agent at once across the pool
+		std::vector<unsigned int> agents(crowd.numAgents());
+		for (unsigned int agent = 0; agent < agents.size(); agent++)
+			agents[agent] = agent;
+		planBatch(agents);
+	}
+
+	// A* for the given agents at once across the pool, testing any lazily added edges the paths use
+	void planBatch(const std::vector<unsigned int> &agents)
+	{
+		std::vector<PathQuery> queries(agents.size());
+		for (unsigned int a = 0; a < agents.size(); a++)
+		{
+			queries[a].start = startIndices[agents[a]];
+			queries[a].goal = goalIndices[agents[a]];
+		}
+		std::vector<std::vector<unsigned int>> paths;
+		roadmap.findValidPaths(queries, aStar, obstacles, pool, paths);
+		for (unsigned int a = 0; a < agents.size(); a++)
+		{
+			agentPaths[agents[a]].swap(paths[a]);
+			sendPath(agents[a]);
+		}
+	}
+
+	// One reverse Dijkstra per distinct goal node, so planning costs scale with the number of goals and not agents
+	void buildFlowFields()
+	{
+		PROFILE_SCOPE("buildFlowFields");
+		std::vector<unsigned int> goalNodes(goalIndices.begin(), goalIndices.end());
+		std::sort(goalNodes.begin(), goalNodes.end());
+		goalNodes.erase(std::unique(goalNodes.begin(), goalNodes.end()), goalNodes.end());
+
+		flowFields.resize(goalNodes.size());
+		pool.parallelFor(goalNodes.size(), 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int f = begin; f < end; f++)
+				flowFields[f].build(roadmap, goalNodes[f]);
+		});
+
+		agentFields.resize(crowd.numAgents());
+		for (unsigned int agent = 0; agent < crowd.numAgents(); agent++)
+			agentFields[agent] = std::lower_bound(goalNodes.begin(), goalNodes.end(), goalIndices[agent]) - goalNodes.begin();
+	}
+
+	// Search from the agent's start node, carrying on from its last search if it is incremental and the goal is the same
+	// Only touches the agent's own state, so different agents can be planned in parallel once searches is big enough,
+	// unless the roadmap is lazy and edges get tested (use planBatch)
+	void planPath(unsigned int agent)
+	{
+		std::vector<unsigned int> &path = agentPaths[agent];
+		if (sharedGoals && agent < agentFields.size())
+		{
+			flowFields[agentFields[agent]].pathFrom(startIndices[agent], path);
+		}
+		else if (incremental)
+		{
+			if (searches.size() < crowd.numAgents())
+				searches.resize(crowd.numAgents());
+			DStarLite &search = searches[agent];
+			if (search.empty() || search.goalNode() != goalIndices[agent])
+			{
+				search.reset(roadmap, goalIndices[agent], startIndices[agent], removedEdges.size());
+			}
+			else
+			{
+				search.nodesAdded(roadmap);
+				search.edgesRemoved(roadmap, removedEdges);
+				search.moveStart(roadmap, startIndices[agent]);
+			}
+			search.computePath(roadmap, path);
+		}
+		else if (roadmap.lazy)
+		{
+			std::vector<PathQuery> query(1);
+			query[0].start = startIndices[agent];
+			query[0].goal = goalIndices[agent];
+			std::vector<std::vector<unsigned int>> paths;
+			roadmap.findValidPaths(query, aStar, obstacles, pool, paths);
+			path.swap(paths[0]);
+		}
+		else
+		{
+			roadmap.findPath(startIndices[agent], goalIndices[agent], aStar, path);
+		}
+
+		sendPath(agent);
+	}
+
+	// Hand the agent's roadmap path to the crowd, smoothing it first
+	void sendPath(unsigned int agent)
+	{
+		std::vector<unsigned int> &path = agentPaths[agent];
+		if (smoothPaths)
+			roadmap.shortcutPath(path, obstacles);
+		// Agent pops waypoints off the back of the path
+		std::vector<glm::vec3> waypoints;
+		for (unsigned int i = 0; i < path.size(); i++)
+			waypoints.push_back(roadmap.points[path[i]]);
+		crowd.setPath(agent, waypoints);
+	}
+
+	// Drop the edges a new obstacle inside bounds blocks and replan only the agents with one of them still ahead
+	// The replanned agents get a new roadmap node at their current position to start from
+	template <typename F>
+	void repairAround(const ObstacleGrid::Box &bounds, F blocked)
+	{
+		PROFILE_SCOPE("repairAround");
+		std::vector<unsigned long long> removed;
+		roadmap.removeEdges(bounds, blocked, pool, removed);
+		if (incremental)
+			removedEdges.insert(removedEdges.end(), removed.begin(), removed.end());
+
+		// The segments ahead are the ones between the waypoints not popped yet, and the one the agent is walking along
+		// Smoothed paths have segments that aren't roadmap edges, so they are tested directly
+		std::vector<unsigned int> replan;
+		for (unsigned int agent = 0; agent < crowd.numAgents(); agent++)
+		{
+			const std::vector<unsigned int> &path = agentPaths[agent];
+			if (path.size() < 2)
+				continue;
+			unsigned int ahead = std::min((unsigned int)crowd.waypointsLeft(agent) + 1, (unsigned int)path.size() - 1);
+			for (unsigned int m = 0; m < ahead; m++)
+			{
+				glm::vec2 p1 = glm::vec2(roadmap.points[path[m]][0], roadmap.points[path[m]][2]);
+				glm::vec2 p2 = glm::vec2(roadmap.points[path[m + 1]][0], roadmap.points[path[m + 1]][2]);
+				if (std::max(p1[0], p2[0]) < bounds.min[0] || std::min(p1[0], p2[0]) > bounds.max[0]
+					|| std::max(p1[1], p2[1]) < bounds.min[1] || std::min(p1[1], p2[1]) > bounds.max[1])
+					continue;
+				if (blocked(p1, p2))
+				{
+					replan.push_back(agent);
+					break;
+				}
+			}
+		}
+		if (sharedGoals && replan.empty())
+			rebuildFlowFields(removed, replan); // Nobody needs a new path, but later ones shouldn't use the dropped edges
+		if (replan.empty())
+			return;
+
+		unsigned int firstNew = roadmap.numNodes();
+		for (unsigned int r = 0; r < replan.size(); r++)
+			startIndices[replan[r]] = roadmap.addPoint(crowd.position(replan[r]));
+		roadmap.connect(obstacles, pool, firstNew);
+
+		if (roadmap.lazy && (sharedGoals || incremental))
+		{
+			// The new start nodes' edges
+			std::vector<unsigned long long> dropped = roadmap.checkEdges(obstacles, pool);
+			if (incremental)
+				removedEdges.insert(removedEdges.end(), dropped.begin(), dropped.end());
+		}
+		if (incremental && searches.size() < crowd.numAgents())
+			searches.resize(crowd.numAgents());
+		if (sharedGoals)
+			rebuildFlowFields(removed, replan);
+		if (!sharedGoals && !incremental)
+		{
+			planBatch(replan);
+			return;
+		}
+		pool.parallelFor(replan.size(), 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int r = begin; r < end; r++)
+				planPath(replan[r]);
+		});
+	}
+
+	// Rebuild the fields whose trees used a removed edge or that a replanned agent (now starting from a node the fields
+	// haven't seen) follows, the rest are still exact
+	void rebuildFlowFields(const std::vector<unsigned long long> &removed, const std::vector<unsigned int> &replan)
+	{
+		PROFILE_SCOPE("rebuildFlowFields");
+		std::vector<bool> stale(flowFields.size(), false);
+		for (unsigned int r = 0; r < replan.size(); r++)
+		{
+			if (replan[r] < agentFields.size())
+				stale[agentFields[replan[r]]] = true;
+		}
+		std::vector<unsigned int> rebuild;
+		for (unsigned int f = 0; f < flowFields.size(); f++)
+		{
+			for (unsigned int k = 0; k < removed.size() && !stale[f]; k++)
+				stale[f] = flowFields[f].usesEdge(removed[k] >> 32, removed[k] & 0xFFFFFFFFu);
+			if (stale[f])
+				rebuild.push_back(f);
+		}
+		pool.parallelFor(rebuild.size(), 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int r = begin; r < end; r++)
+				flowFields[rebuild[r]].build(roadmap, flowFields[rebuild[r]].goal);
+		});
+	}
+
+	void createRoadmap(unsigned int seed)
+	{
+		buildRoadmap(seed);
+		planPaths();
+	}
+};
+
+#endif
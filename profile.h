@@ -0,0 +1,235 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Low overhead profiling: scoped timers recorded into per thread ring buffers, plus global counters
+// Nothing is recorded until Profiler::instance().setEnabled(true), and while disabled a timer or counter costs one
+// relaxed load. Build with NO_PROFILING to compile the PROFILE_ macros away entirely
+// Dump with writeChromeTrace (open in chrome://tracing or Perfetto) or writeCsv once nothing is recording
+
+enum ProfileCounter : unsigned int
+{
+	COUNTER_SAMPLES,          // Roadmap points sampled
+	COUNTER_EDGE_CHECKS,      // Roadmap edges tested against the obstacles
+	COUNTER_EXPANSIONS,       // Nodes expanded by roadmap searches
+	COUNTER_VISIBILITY_TESTS, // Segments tested while shortcutting paths
+	COUNTER_TTC_PAIRS,        // Agent pairs streamed through the TTC kernel
+	COUNTER_AGENT_STEPS,      // Agents integrated
+	COUNTER_DRAW_CALLS,       // Mesh draw calls
+	NUM_COUNTERS
+};
+
+inline const char *profileCounterName(unsigned int counter)
+{
+	static const char *names[NUM_COUNTERS] = { "samples", "edgeChecks", "expansions", "visibilityTests", "ttcPairs",
+		"agentSteps", "drawCalls" };
+	return names[counter];
+}
+
+struct ProfileEvent
+{
+	const char *name;   // A string literal, so only the pointer is kept
+	long long start;    // Nanoseconds since the profiler was created
+	long long duration;
+};
+
+class Profiler
+{
+public:
+	enum : unsigned int { RING_SIZE = 1 << 16 }; // Events kept per thread, older ones are overwritten
+
+	static Profiler &instance()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	long long now() const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	// Only the calling thread writes to its ring, so recording takes no lock once the ring exists
+	void record(const char *name, long long start, long long end)
+	{
+		ThreadBuffer &buffer = threadBuffer();
+		unsigned long long i = buffer.written.load(std::memory_order_relaxed);
+		ProfileEvent &event = buffer.events[i & (RING_SIZE - 1)];
+		event.name = name;
+		event.start = start;
+		event.duration = end - start;
+		buffer.written.store(i + 1, std::memory_order_release);
+	}
+
+	// Callers in tight loops should add up locally and count once per batch, the counters are shared by every thread
+	void count(ProfileCounter counter, unsigned long long n = 1)
+	{
+		if (isEnabled())
+			counters[counter].fetch_add(n, std::memory_order_relaxed);
+	}
+
+	unsigned long long counterValue(unsigned int counter) const { return counters[counter].load(std::memory_order_relaxed); }
+
+	// Forget every event and counter, only while nothing is recording
+	void reset()
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (unsigned int b = 0; b < buffers.size(); b++)
+			buffers[b]->written.store(0, std::memory_order_relaxed);
+		for (unsigned int c = 0; c < NUM_COUNTERS; c++)
+			counters[c].store(0, std::memory_order_relaxed);
+	}
+
+	// Timers as complete ("X") events on their thread's track, counters as one counter ("C") event at the end
+	bool writeChromeTrace(const std::string &fileName) const
+	{
+		FILE *file = fopen(fileName.c_str(), "w");
+		if (!file)
+			return false;
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		long long last = 0;
+		bool first = true;
+		forEachEvent([&](unsigned int thread, const ProfileEvent &event)
+		{
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+				event.name, thread, event.start / 1000.0, event.duration / 1000.0);
+			last = std::max(last, event.start + event.duration);
+			first = false;
+		});
+		fprintf(file, "%s{\"name\":\"counters\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"args\":{", first ? "" : ",\n", last / 1000.0);
+		for (unsigned int c = 0; c < NUM_COUNTERS; c++)
+			fprintf(file, "%s\"%s\":%llu", c > 0 ? "," : "", profileCounterName(c), counterValue(c));
+		fprintf(file, "}}\n]}\n");
+		return fclose(file) == 0;
+	}
+
+	// One row per timer then one per counter: type,name,thread,start_us,duration_us,value
+	bool writeCsv(const std::string &fileName) const
+	{
+		FILE *file = fopen(fileName.c_str(), "w");
+		if (!file)
+			return false;
+		fprintf(file, "type,name,thread,start_us,duration_us,value\n");
+		forEachEvent([&](unsigned int thread, const ProfileEvent &event)
+		{
+			fprintf(file, "timer,%s,%u,%.3f,%.3f,\n", event.name, thread, event.start / 1000.0, event.duration / 1000.0);
+		});
+		for (unsigned int c = 0; c < NUM_COUNTERS; c++)
+			fprintf(file, "counter,%s,,,,%llu\n", profileCounterName(c), counterValue(c));
+		return fclose(file) == 0;
+	}
+
+	// Total time and count of every timer with the given name, over the events still in the rings
+	void totals(const char *name, double &ms, unsigned long long &calls) const
+	{
+		long long ns = 0;
+		calls = 0;
+		forEachEvent([&](unsigned int, const ProfileEvent &event)
+		{
+			if (strcmp(event.name, name) == 0)
+			{
+				ns += event.duration;
+				calls++;
+			}
+		});
+		ms = ns / 1e6;
+	}
+
+private:
+	struct ThreadBuffer
+	{
+		unsigned int thread = 0;
+		std::vector<ProfileEvent> events;
+		std::atomic<unsigned long long> written{ 0 };
+	};
+
+	std::atomic<bool> enabled{ false };
+	std::chrono::steady_clock::time_point epoch;
+	std::atomic<unsigned long long> counters[NUM_COUNTERS];
+	mutable std::mutex buffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Kept after their thread exits so its events can be dumped
+
+	Profiler() : epoch(std::chrono::steady_clock::now())
+	{
+		for (unsigned int c = 0; c < NUM_COUNTERS; c++)
+			counters[c].store(0, std::memory_order_relaxed);
+	}
+
+	Profiler(const Profiler &) = delete;
+	Profiler &operator=(const Profiler &) = delete;
+
+	ThreadBuffer &threadBuffer()
+	{
+		thread_local ThreadBuffer *buffer = nullptr;
+		if (!buffer)
+		{
+			std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+			created->events.resize(RING_SIZE);
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			created->thread = buffers.size();
+			buffer = created.get();
+			buffers.push_back(std::move(created));
+		}
+		return *buffer;
+	}
+
+	template <typename F>
+	void forEachEvent(F f) const
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (unsigned int b = 0; b < buffers.size(); b++)
+		{
+			const ThreadBuffer &buffer = *buffers[b];
+			unsigned long long written = buffer.written.load(std::memory_order_acquire);
+			unsigned long long first = written > RING_SIZE ? written - RING_SIZE : 0;
+			for (unsigned long long i = first; i < written; i++)
+				f(buffer.thread, buffer.events[i & (RING_SIZE - 1)]);
+		}
+	}
+};
+
+// Records the time from construction to destruction under name, if the profiler was enabled at construction
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char *name) : name(name), start(Profiler::instance().isEnabled() ? Profiler::instance().now() : -1)
+	{
+	}
+
+	~ProfileScope()
+	{
+		if (start >= 0)
+			Profiler::instance().record(name, start, Profiler::instance().now());
+	}
+
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+	const char *name;
+	long long start;
+};
+
+#ifdef NO_PROFILING
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(counter, n)
+#else
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(counter, n) Profiler::instance().count(counter, n)
+#endif
+
+#endif
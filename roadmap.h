@@ -0,0 +1,741 @@
+#ifndef ROADMAP_H
+#define ROADMAP_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "indexed_heap.h"
+#include "kd_tree.h"
+#include "obstacles.h"
+#include "profile.h"
+#include "thread_pool.h"
+
+// Which pairs of points connect tries to join
+enum ConnectionStrategy
+{
+	CONNECT_ALL,       // Every pair, edges grow with the square of the point count
+	CONNECT_K_NEAREST, // Each point's k nearest neighbours (PRM*)
+	CONNECT_RADIUS     // Every pair closer than the connection radius
+};
+
+// Start and goal node of one search in a batch
+struct PathQuery
+{
+	unsigned int start;
+	unsigned int goal;
+};
+
+// Working memory for roadmap searches, reused from one search to the next
+// Each search bumps the generation instead of refilling the arrays, and an entry only counts if it was stamped with the
+// current generation, so starting a search costs nothing however big the roadmap is
+class SearchScratch
+{
+public:
+	std::vector<float> gVal;            // Cost of getting to each node
+	std::vector<unsigned int> cameFrom; // For each node the best node to get their from
+	IndexedHeap fringe;
+
+	// Get ready for a search over numNodes nodes
+	void begin(unsigned int numNodes)
+	{
+		if (reached.size() < numNodes)
+		{
+			reached.resize(numNodes, 0);
+			explored.resize(numNodes, 0);
+			gVal.resize(numNodes);
+			cameFrom.resize(numNodes);
+			fringe.grow(numNodes);
+		}
+		fringe.clear();
+		generation++;
+		if (generation == 0)
+		{
+			// Wrapped, so old stamps could look current
+			std::fill(reached.begin(), reached.end(), 0);
+			std::fill(explored.begin(), explored.end(), 0);
+			generation = 1;
+		}
+	}
+
+	float cost(unsigned int node) const { return reached[node] == generation ? gVal[node] : INFINITY; }
+	bool closed(unsigned int node) const { return explored[node] == generation; }
+
+	void reach(unsigned int node, float g, unsigned int from)
+	{
+		reached[node] = generation;
+		gVal[node] = g;
+		cameFrom[node] = from;
+	}
+
+	void close(unsigned int node) { explored[node] = generation; }
+
+private:
+	unsigned int generation = 0;
+	std::vector<unsigned int> reached;  // Generation gVal and cameFrom were last set in
+	std::vector<unsigned int> explored; // Generation the node was last explored in
+};
+
+// The calling thread's own scratch, pool workers live as long as the pool so theirs is reused by every batch
+inline SearchScratch &threadSearchScratch()
+{
+	static thread_local SearchScratch scratch;
+	return scratch;
+}
+
+// Probabilistic roadmap over the ground plane
+class Roadmap
+{
+public:
+	ConnectionStrategy connection = CONNECT_ALL;
+	unsigned int connectK = 0;    // Neighbours for CONNECT_K_NEAREST, 0 for the PRM* value e(1 + 1/d) log n
+	float connectRadius = 0.0f;   // Radius for CONNECT_RADIUS, 0 for the PRM* value gamma (log n / n)^(1/d)
+	bool lazy = false;            // Add candidate edges untested and only test the ones searches expand (LazyPRM)
+
+	std::vector<glm::vec3> points;
+
+	// Adjacency in compressed sparse row form, for searching
+	// The neighbours of node i are edgeTargets[edgeOffsets[i]] to edgeTargets[edgeOffsets[i + 1] - 1], in increasing order
+	std::vector<unsigned int> edgeOffsets;
+	std::vector<unsigned int> edgeTargets;
+	std::vector<float> edgeCosts; // Length of each edge in edgeTargets
+	std::vector<unsigned char> edgeChecked; // 1 if the edge in edgeTargets is known to be clear, only ever 0 when lazy
+
+	std::vector<unsigned int> edgeIndices; // For drawing roadmap, each edge once
+
+	unsigned int numNodes() const { return points.size(); }
+	unsigned int numEdges() const { return edgeIndices.size() / 2; }
+
+	void clear()
+	{
+		points.clear();
+		edgeOffsets.clear();
+		edgeTargets.clear();
+		edgeCosts.clear();
+		edgeChecked.clear();
+		edgeIndices.clear();
+	}
+
+	unsigned int addPoint(glm::vec3 point)
+	{
+		points.push_back(point);
+		return points.size() - 1;
+	}
+
+	// Add n uniformly random points in a mapSize square centred on the origin (uses rand, so seed with srand)
+	void sample(int n, float mapSize)
+	{
+		PROFILE_SCOPE("sampleRoadmap");
+		PROFILE_COUNT(COUNTER_SAMPLES, n);
+		for (int i = 0; i < n; i++)
+		{
+			float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+			float x = (r - 0.5f) * mapSize;
+			r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+			float z = (r - 0.5f) * mapSize;
+			points.push_back(glm::vec3(x, 0.0f, z));
+		}
+	}
+
+	// Connect point pairs chosen by the connection strategy that have line of sight, or all of them if lazy
+	// Points before firstNew keep the edges they already have between them and only pairs involving a newer point are
+	// tested, so points can be added to a connected roadmap. With firstNew 0 every existing edge is replaced
+	// Each pair is only tested once (i < j) and rows are shared out over the pool. Every chunk of rows collects its
+	// edges in its own buffer and the buffers are merged in row order, so the result doesn't depend on the thread count
+	void connect(const ObstacleSet &obstacles, ThreadPool &pool, unsigned int firstNew = 0)
+	{
+		PROFILE_SCOPE("connectRoadmap");
+		unsigned int numNodes = points.size();
+		if (edgeOffsets.size() != firstNew + 1)
+			firstNew = 0; // The old points were never connected
+		if (connection != CONNECT_ALL)
+			findNeighbours(pool, firstNew);
+
+		const unsigned int grain = 8; // Rows per chunk, small since rows can have very different numbers of pairs
+		unsigned int numChunks = (numNodes + grain - 1) / grain;
+		std::vector<std::vector<unsigned int>> chunkEdges(numChunks); // Pairs i, j
+
+		pool.parallelFor(numNodes, grain, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<unsigned int> candidates;
+			unsigned long long tests = 0;
+			// Chunks can be merged by parallelFor when it runs inline, so split them back up
+			for (unsigned int chunkBegin = begin; chunkBegin < end; chunkBegin += grain)
+			{
+				std::vector<unsigned int> &local = chunkEdges[chunkBegin / grain];
+				unsigned int chunkEnd = std::min(end, chunkBegin + grain);
+				for (unsigned int i = chunkBegin; i < chunkEnd; i++)
+				{
+					glm::vec2 p1 = glm::vec2(points[i][0], points[i][2]);
+					if (connection == CONNECT_ALL)
+					{
+						if (!lazy)
+							tests += numNodes - std::min(numNodes, std::max(i + 1, firstNew));
+						for (unsigned int j = std::max(i + 1, firstNew); j < numNodes; j++)
+						{
+							glm::vec2 p2 = glm::vec2(points[j][0], points[j][2]);
+							if (lazy || !obstacles.collidesWithObs(p1, p2))
+							{
+								local.push_back(i);
+								local.push_back(j);
+							}
+						}
+					}
+					else
+					{
+						rowCandidates(i, candidates);
+						if (!lazy)
+							tests += candidates.size();
+						for (unsigned int c = 0; c < candidates.size(); c++)
+						{
+							unsigned int j = candidates[c];
+							glm::vec2 p2 = glm::vec2(points[j][0], points[j][2]);
+							if (lazy || !obstacles.collidesWithObs(p1, p2))
+							{
+								local.push_back(i);
+								local.push_back(j);
+							}
+						}
+					}
+				}
+			}
+			PROFILE_COUNT(COUNTER_EDGE_CHECKS, tests);
+		});
+
+		// Count both directions of every edge, then prefix sum into offsets
+		if (firstNew == 0)
+			edgeIndices.clear();
+		std::vector<unsigned int> oldOffsets;
+		std::vector<unsigned char> oldChecked;
+		if (firstNew > 0)
+		{
+			oldOffsets.swap(edgeOffsets);
+			oldChecked.swap(edgeChecked);
+		}
+		edgeOffsets.assign(numNodes + 1, 0);
+		for (unsigned int k = 0; k < edgeIndices.size(); k += 2)
+		{
+			edgeOffsets[edgeIndices[k] + 1]++;
+			edgeOffsets[edgeIndices[k + 1] + 1]++;
+		}
+		for (unsigned int c = 0; c < numChunks; c++)
+		{
+			const std::vector<unsigned int> &local = chunkEdges[c];
+			for (unsigned int k = 0; k < local.size(); k += 2)
+			{
+				edgeOffsets[local[k] + 1]++;
+				edgeOffsets[local[k + 1] + 1]++;
+			}
+			edgeIndices.insert(edgeIndices.end(), local.begin(), local.end());
+		}
+		for (unsigned int i = 0; i < numNodes; i++)
+			edgeOffsets[i + 1] += edgeOffsets[i];
+
+		// Pairs are in (i, j) order, with any kept edges first and all new pairs ending in a newer point, so filling in that
+		// order leaves every node's neighbours sorted
+		edgeTargets.resize(edgeOffsets[numNodes]);
+		edgeCosts.resize(edgeOffsets[numNodes]);
+		std::vector<unsigned int> fill(edgeOffsets.begin(), edgeOffsets.end() - 1);
+		for (unsigned int k = 0; k < edgeIndices.size(); k += 2)
+		{
+			unsigned int i = edgeIndices[k], j = edgeIndices[k + 1];
+			float cost = glm::length(points[j] - points[i]);
+			edgeTargets[fill[i]] = j;
+			edgeCosts[fill[i]++] = cost;
+			edgeTargets[fill[j]] = i;
+			edgeCosts[fill[j]++] = cost;
+		}
+
+		// Kept edges come first in their rows in the same order as before, so they keep whether they were tested
+		edgeChecked.assign(edgeOffsets[numNodes], lazy ? 0 : 1);
+		for (unsigned int i = 0; i + 1 < oldOffsets.size(); i++)
+		{
+			for (unsigned int e = oldOffsets[i]; e < oldOffsets[i + 1]; e++)
+				edgeChecked[edgeOffsets[i] + e - oldOffsets[i]] = oldChecked[e];
+		}
+	}
+
+	// Test every edge added lazily that hasn't been yet, dropping the blocked ones, for searches that need the whole
+	// roadmap to be valid. Returns the dropped edges' keys sorted
+	std::vector<unsigned long long> checkEdges(const ObstacleSet &obstacles, ThreadPool &pool)
+	{
+		std::vector<unsigned long long> keys;
+		for (unsigned int i = 0; i < points.size() && i + 1 < edgeOffsets.size(); i++)
+		{
+			for (unsigned int e = edgeOffsets[i]; e < edgeOffsets[i + 1]; e++)
+			{
+				if (!edgeChecked[e] && edgeTargets[e] > i)
+					keys.push_back(edgeKey(i, edgeTargets[e]));
+			}
+		}
+		return checkEdgeKeys(keys, obstacles, pool);
+	}
+
+	// Searches like findPaths, but on a lazy roadmap untested edges are tested as the searches reach them and skipped
+	// if blocked. Searches share what they have tested while they run, and the results are applied to the roadmap
+	// afterwards so later searches over the same area don't repeat them either
+	unsigned int findValidPaths(const std::vector<PathQuery> &queries, bool aStar, const ObstacleSet &obstacles, ThreadPool &pool, std::vector<std::vector<unsigned int>> &paths)
+	{
+		if (!lazy)
+			return findPaths(queries, aStar, pool, paths);
+
+		PROFILE_SCOPE("findValidPaths");
+		unsigned int numEntries = edgeTargets.size();
+		std::unique_ptr<std::atomic<unsigned char>[]> edgeTests(new std::atomic<unsigned char>[numEntries]);
+		for (unsigned int e = 0; e < numEntries; e++)
+			edgeTests[e].store(edgeChecked[e] ? EDGE_CLEAR : EDGE_UNTESTED, std::memory_order_relaxed);
+
+		paths.resize(queries.size());
+		std::vector<unsigned char> found(queries.size(), 0);
+		pool.parallelFor(queries.size(), 16, [&](unsigned int begin, unsigned int end)
+		{
+			SearchScratch &scratch = threadSearchScratch();
+			for (unsigned int q = begin; q < end; q++)
+				found[q] = findPath(queries[q].start, queries[q].goal, aStar, paths[q], scratch, &obstacles, edgeTests.get());
+		});
+
+		std::vector<unsigned long long> blocked;
+		for (unsigned int i = 0; i < points.size(); i++)
+		{
+			for (unsigned int e = edgeOffsets[i]; e < edgeOffsets[i + 1]; e++)
+			{
+				unsigned char state = edgeTests[e].load(std::memory_order_relaxed);
+				if (state == EDGE_CLEAR)
+					edgeChecked[e] = 1;
+				else if (state == EDGE_BLOCKED && edgeTargets[e] > i)
+					blocked.push_back(edgeKey(i, edgeTargets[e]));
+			}
+		}
+		removeEdgeKeys(blocked);
+
+		unsigned int numFound = 0;
+		for (unsigned int q = 0; q < found.size(); q++)
+			numFound += found[q];
+		return numFound;
+	}
+
+	// Drop every edge whose segment overlaps bounds and that blocked(p1, p2) says is now blocked, eg after an obstacle
+	// is added inside bounds. The CSR arrays are compacted in place and removed gets the dropped pairs (i < j) sorted
+	template <typename F>
+	void removeEdges(const ObstacleGrid::Box &bounds, F blocked, ThreadPool &pool, std::vector<unsigned long long> &removed)
+	{
+		removed.clear();
+		unsigned int numNodes = points.size();
+		if (edgeOffsets.size() != numNodes + 1)
+			return;
+
+		// Each row tests its edges to higher numbered nodes, skipping any whose bounding box misses bounds
+		const unsigned int grain = 64;
+		std::vector<std::vector<unsigned long long>> chunkRemoved((numNodes + grain - 1) / grain);
+		pool.parallelFor(numNodes, grain, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				glm::vec2 p1 = glm::vec2(points[i][0], points[i][2]);
+				for (unsigned int e = edgeOffsets[i]; e < edgeOffsets[i + 1]; e++)
+				{
+					unsigned int j = edgeTargets[e];
+					if (j < i)
+						continue;
+					glm::vec2 p2 = glm::vec2(points[j][0], points[j][2]);
+					if (std::max(p1[0], p2[0]) < bounds.min[0] || std::min(p1[0], p2[0]) > bounds.max[0]
+						|| std::max(p1[1], p2[1]) < bounds.min[1] || std::min(p1[1], p2[1]) > bounds.max[1])
+						continue;
+					if (blocked(p1, p2))
+						chunkRemoved[i / grain].push_back(edgeKey(i, j));
+				}
+			}
+		});
+		for (unsigned int c = 0; c < chunkRemoved.size(); c++)
+			removed.insert(removed.end(), chunkRemoved[c].begin(), chunkRemoved[c].end());
+		removeEdgeKeys(removed);
+	}
+
+	// Drop the edges with the given keys (see edgeKey), compacting the CSR arrays in place
+	void removeEdgeKeys(const std::vector<unsigned long long> &removed)
+	{
+		unsigned int numNodes = points.size();
+		if (removed.empty())
+			return;
+
+		// Flag both directions of every removed edge in place, rows are sorted so each is a short binary search
+		std::vector<unsigned char> drop(edgeTargets.size(), 0);
+		std::vector<bool> touched(numNodes, false);
+		for (unsigned int r = 0; r < removed.size(); r++)
+		{
+			unsigned int i = removed[r] >> 32, j = removed[r] & 0xFFFFFFFFu;
+			drop[findEdge(i, j)] = 1;
+			drop[findEdge(j, i)] = 1;
+			touched[i] = true;
+		}
+
+		// Only pairs starting at a node that lost an edge need looking up
+		unsigned int out = 0;
+		for (unsigned int k = 0; k < edgeIndices.size(); k += 2)
+		{
+			unsigned int i = std::min(edgeIndices[k], edgeIndices[k + 1]), j = std::max(edgeIndices[k], edgeIndices[k + 1]);
+			if (touched[i] && drop[findEdge(i, j)])
+				continue;
+			edgeIndices[out++] = edgeIndices[k];
+			edgeIndices[out++] = edgeIndices[k + 1];
+		}
+		edgeIndices.resize(out);
+
+		// Compact every row, keeping the order so rows stay sorted
+		out = 0;
+		unsigned int rowBegin = 0;
+		for (unsigned int i = 0; i < numNodes; i++)
+		{
+			unsigned int rowEnd = edgeOffsets[i + 1];
+			edgeOffsets[i] = out;
+			for (unsigned int e = rowBegin; e < rowEnd; e++)
+			{
+				if (drop[e])
+					continue;
+				edgeTargets[out] = edgeTargets[e];
+				edgeChecked[out] = edgeChecked[e];
+				edgeCosts[out++] = edgeCosts[e];
+			}
+			rowBegin = rowEnd;
+		}
+		edgeOffsets[numNodes] = out;
+		edgeTargets.resize(out);
+		edgeCosts.resize(out);
+		edgeChecked.resize(out);
+	}
+
+	// Key for the undirected edge between i and j, as listed by removeEdges
+	static unsigned long long edgeKey(unsigned int i, unsigned int j)
+	{
+		return i < j ? ((unsigned long long)i << 32) | j : ((unsigned long long)j << 32) | i;
+	}
+
+	// True if sortedKeys holds the edge between i and j
+	static bool hasEdgeKey(const std::vector<unsigned long long> &sortedKeys, unsigned int i, unsigned int j)
+	{
+		return std::binary_search(sortedKeys.begin(), sortedKeys.end(), edgeKey(i, j));
+	}
+
+	// Position of the edge from i to j in edgeTargets, which must exist
+	unsigned int findEdge(unsigned int i, unsigned int j) const
+	{
+		return std::lower_bound(edgeTargets.begin() + edgeOffsets[i], edgeTargets.begin() + edgeOffsets[i + 1], j) - edgeTargets.begin();
+	}
+
+	// Test the edges with the given keys (sorted, unique) across the pool, marking the clear ones checked and dropping
+	// the blocked ones, which are returned sorted
+	std::vector<unsigned long long> checkEdgeKeys(const std::vector<unsigned long long> &keys, const ObstacleSet &obstacles, ThreadPool &pool)
+	{
+		PROFILE_SCOPE("checkEdges");
+		PROFILE_COUNT(COUNTER_EDGE_CHECKS, keys.size());
+		std::vector<unsigned char> blocked(keys.size(), 0);
+		pool.parallelFor(keys.size(), 64, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int k = begin; k < end; k++)
+			{
+				glm::vec3 a = points[keys[k] >> 32], b = points[keys[k] & 0xFFFFFFFFu];
+				blocked[k] = obstacles.collidesWithObs(glm::vec2(a[0], a[2]), glm::vec2(b[0], b[2]));
+			}
+		});
+
+		std::vector<unsigned long long> removed;
+		for (unsigned int k = 0; k < keys.size(); k++)
+		{
+			unsigned int i = keys[k] >> 32, j = keys[k] & 0xFFFFFFFFu;
+			if (blocked[k])
+			{
+				removed.push_back(keys[k]);
+			}
+			else
+			{
+				edgeChecked[findEdge(i, j)] = 1;
+				edgeChecked[findEdge(j, i)] = 1;
+			}
+		}
+		removeEdgeKeys(removed);
+		return removed;
+	}
+
+	// Number of neighbours CONNECT_K_NEAREST uses for n points
+	unsigned int neighbourCount(unsigned int n) const
+	{
+		if (connectK > 0)
+			return connectK;
+		// k > e(1 + 1/d) log n keeps PRM* asymptotically optimal, with d = 2
+		return (unsigned int)std::ceil(std::exp(1.0f) * 1.5f * std::log((float)std::max(2u, n)));
+	}
+
+	// Radius CONNECT_RADIUS uses for n points
+	float neighbourRadius(unsigned int n) const
+	{
+		if (connectRadius > 0.0f || n < 2)
+			return connectRadius;
+
+		// gamma > 2 (1 + 1/d)^(1/d) (area / unit disc area)^(1/d), with the area of the points' bounding box standing in
+		// for the free space
+		glm::vec3 lo = points[0], hi = points[0];
+		for (unsigned int i = 1; i < n; i++)
+		{
+			lo = glm::min(lo, points[i]);
+			hi = glm::max(hi, points[i]);
+		}
+		float area = std::max(1e-6f, (hi[0] - lo[0]) * (hi[2] - lo[2]));
+		float gamma = 1.01f * 2.0f * std::sqrt(1.5f) * std::sqrt(area / 3.14159265f);
+		return gamma * std::sqrt(std::log((float)n) / n);
+	}
+
+	// A* (or uniform cost search if aStar is false) over the roadmap
+	// Fills path with node indices from goal back to start, or just start if goal can't be reached
+	bool findPath(unsigned int start, unsigned int goal, bool aStar, std::vector<unsigned int> &path) const
+	{
+		return findPath(start, goal, aStar, path, threadSearchScratch());
+	}
+
+	// Same as above with the working memory supplied, so repeated searches don't allocate or clear per node arrays
+	// Given obstacles (for lazy roadmaps), edges not checked yet are tested when the search expands them and skipped if
+	// blocked. Results go in edgeTests, one entry per edge in edgeTargets shared by searches running together
+	bool findPath(unsigned int start, unsigned int goal, bool aStar, std::vector<unsigned int> &path, SearchScratch &scratch,
+		const ObstacleSet *obstacles = nullptr, std::atomic<unsigned char> *edgeTests = nullptr) const
+	{
+		scratch.begin(points.size());
+		IndexedHeap &fringe = scratch.fringe; //Known nodes not yet explored, keyed by fVal
+
+		scratch.reach(start, 0.0f, start);
+		fringe.push(start, glm::length(points[start] - points[goal]));
+
+		bool found = false;
+		unsigned int expanded = 0;
+		while (!fringe.empty())
+		{
+			// Explore lowest cost node in fringe
+			unsigned int current = fringe.pop();
+			scratch.close(current);
+			expanded++;
+			if (current == goal)
+			{
+				found = true;
+				break;
+			}
+
+			// For each neighbor of current node
+			float currentG = scratch.gVal[current];
+			for (unsigned int e = edgeOffsets[current]; e < edgeOffsets[current + 1]; e++)
+			{
+				unsigned int lookingAt = edgeTargets[e];
+				if (scratch.closed(lookingAt))
+					continue;
+
+				float pathLength = currentG + edgeCosts[e];
+				// If there isn't already a better path
+				if (pathLength < scratch.cost(lookingAt))
+				{
+					if (obstacles && !edgeChecked[e] && !testEdge(*obstacles, edgeTests, current, e))
+						continue;
+					scratch.reach(lookingAt, pathLength, current);
+					if (aStar)
+						fringe.push(lookingAt, 1.0f * pathLength + 1.0f * glm::length(points[lookingAt] - points[goal]));
+					else
+						fringe.push(lookingAt, pathLength);
+				}
+			}
+		}
+
+		PROFILE_COUNT(COUNTER_EXPANSIONS, expanded);
+		return buildPath(start, goal, found, scratch, path);
+	}
+
+	// String pull a path (goal first, as findPath fills it): from the start, skip ahead to the furthest node that can be
+	// reached in a straight line before the first that can't, and repeat from there
+	// Costs one segment test per node on the path, so it is done once per plan rather than by the agents as they walk
+	void shortcutPath(std::vector<unsigned int> &path, const ObstacleSet &obstacles) const
+	{
+		if (path.size() < 3)
+			return;
+
+		unsigned int out = path.size() - 1; // Smoothed path is built in place, filling from the back
+		unsigned int anchor = path.size() - 1;
+		unsigned int tests = 0;
+		while (anchor > 0)
+		{
+			glm::vec2 from = glm::vec2(points[path[anchor]][0], points[path[anchor]][2]);
+			unsigned int next = anchor - 1;
+			while (next > 0)
+			{
+				glm::vec2 to = glm::vec2(points[path[next - 1]][0], points[path[next - 1]][2]);
+				tests++;
+				if (obstacles.collidesWithObs(from, to))
+					break;
+				next--;
+			}
+			path[--out] = path[next];
+			anchor = next;
+		}
+		path.erase(path.begin(), path.begin() + out);
+		PROFILE_COUNT(COUNTER_VISIBILITY_TESTS, tests);
+	}
+
+	// Run many searches at once across the pool, each worker reusing its own scratch memory
+	// paths[q] gets the path for queries[q] as findPath would fill it, returns how many reached their goal
+	unsigned int findPaths(const std::vector<PathQuery> &queries, bool aStar, ThreadPool &pool, std::vector<std::vector<unsigned int>> &paths) const
+	{
+		PROFILE_SCOPE("findPaths");
+		paths.resize(queries.size());
+		std::vector<unsigned char> found(queries.size(), 0);
+		pool.parallelFor(queries.size(), 16, [&](unsigned int begin, unsigned int end)
+		{
+			SearchScratch &scratch = threadSearchScratch();
+			for (unsigned int q = begin; q < end; q++)
+				found[q] = findPath(queries[q].start, queries[q].goal, aStar, paths[q], scratch);
+		});
+
+		unsigned int numFound = 0;
+		for (unsigned int q = 0; q < found.size(); q++)
+			numFound += found[q];
+		return numFound;
+	}
+
+private:
+	enum : unsigned char { EDGE_UNTESTED, EDGE_CLEAR, EDGE_BLOCKED }; // Lazy edge states while searches run
+
+	// Whether the edge at e out of node i is clear, testing it unless a search already has
+	// Both directions of the edge get the result. Two searches can race to test the same edge, which only costs a test
+	bool testEdge(const ObstacleSet &obstacles, std::atomic<unsigned char> *edgeTests, unsigned int i, unsigned int e) const
+	{
+		unsigned char state = edgeTests[e].load(std::memory_order_relaxed);
+		if (state == EDGE_UNTESTED)
+		{
+			unsigned int j = edgeTargets[e];
+			PROFILE_COUNT(COUNTER_EDGE_CHECKS, 1);
+			bool blocked = obstacles.collidesWithObs(glm::vec2(points[i][0], points[i][2]), glm::vec2(points[j][0], points[j][2]));
+			state = blocked ? EDGE_BLOCKED : EDGE_CLEAR;
+			edgeTests[e].store(state, std::memory_order_relaxed);
+			edgeTests[findEdge(j, i)].store(state, std::memory_order_relaxed);
+		}
+		return state == EDGE_CLEAR;
+	}
+
+	// Follow cameFrom back from the goal, or just the start if the goal wasn't found
+	bool buildPath(unsigned int start, unsigned int goal, bool found, const SearchScratch &scratch, std::vector<unsigned int> &path) const
+	{
+		//A* is done, build path
+		path.clear();
+		if (found)
+		{
+			unsigned int current = goal;
+			while (current != start)
+			{
+				path.push_back(current);
+				current = scratch.cameFrom[current];
+			}
+		}
+		path.push_back(start);
+		return found;
+	}
+
+	KdTree tree; // Over points, rebuilt by connect for the neighbour strategies
+
+	// Neighbour query results for the points connect is adding, from firstQueried on, in CSR form
+	// and for every point the queried points after it that found it
+	unsigned int firstQueried = 0;
+	std::vector<unsigned int> foundOffsets;
+	std::vector<unsigned int> found;
+	std::vector<unsigned int> foundByOffsets;
+	std::vector<unsigned int> foundBy;
+
+	// Rebuild the tree and run the strategy's neighbour query for every point from firstNew on
+	void findNeighbours(ThreadPool &pool, unsigned int firstNew)
+	{
+		PROFILE_SCOPE("findNeighbours");
+		unsigned int numNodes = points.size();
+		unsigned int numQueried = numNodes - firstNew;
+		tree.build(points);
+		unsigned int k = std::min(neighbourCount(numNodes), numNodes > 0 ? numNodes - 1 : 0);
+		float radius = connection == CONNECT_RADIUS ? neighbourRadius(numNodes) : 0.0f;
+
+		const unsigned int grain = 64;
+		std::vector<std::vector<unsigned int>> chunkFound((numQueried + grain - 1) / grain);
+		std::vector<unsigned int> counts(numQueried);
+		pool.parallelFor(numQueried, grain, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<unsigned int> result;
+			for (unsigned int q = begin; q < end; q++)
+			{
+				unsigned int i = firstNew + q;
+				glm::vec2 p = glm::vec2(points[i][0], points[i][2]);
+				if (connection == CONNECT_RADIUS)
+				{
+					tree.withinRadius(p, radius, result);
+					result.erase(std::remove(result.begin(), result.end(), i), result.end());
+				}
+				else
+				{
+					tree.kNearest(p, k, i, result);
+				}
+				counts[q] = result.size();
+				std::vector<unsigned int> &local = chunkFound[q / grain];
+				local.insert(local.end(), result.begin(), result.end());
+			}
+		});
+
+		firstQueried = firstNew;
+		foundOffsets.assign(numQueried + 1, 0);
+		for (unsigned int q = 0; q < numQueried; q++)
+			foundOffsets[q + 1] = foundOffsets[q] + counts[q];
+		found.clear();
+		for (unsigned int c = 0; c < chunkFound.size(); c++)
+			found.insert(found.end(), chunkFound[c].begin(), chunkFound[c].end());
+
+		// The neighbour relation isn't symmetric for k nearest, and points that weren't queried only know who found them
+		// Radius results are symmetric, so queried points don't need to be told
+		foundByOffsets.assign(numNodes + 1, 0);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			std::vector<unsigned int> fill(foundByOffsets.begin(), foundByOffsets.end() - 1);
+			for (unsigned int q = 0; q < numQueried; q++)
+			{
+				unsigned int j = firstNew + q;
+				for (unsigned int f = foundOffsets[q]; f < foundOffsets[q + 1]; f++)
+				{
+					unsigned int i = found[f];
+					if (i >= j || (connection == CONNECT_RADIUS && i >= firstNew))
+						continue;
+					if (pass == 0)
+						foundByOffsets[i + 1]++;
+					else
+						foundBy[fill[i]++] = j;
+				}
+			}
+			if (pass == 0)
+			{
+				for (unsigned int i = 0; i < numNodes; i++)
+					foundByOffsets[i + 1] += foundByOffsets[i];
+				foundBy.resize(foundByOffsets[numNodes]);
+			}
+		}
+	}
+
+	// Points j > i that should be tested against point i, sorted and without repeats
+	void rowCandidates(unsigned int i, std::vector<unsigned int> &out) const
+	{
+		out.clear();
+		if (i >= firstQueried)
+		{
+			unsigned int q = i - firstQueried;
+			for (unsigned int f = foundOffsets[q]; f < foundOffsets[q + 1]; f++)
+			{
+				if (found[f] > i)
+					out.push_back(found[f]);
+			}
+		}
+		out.insert(out.end(), foundBy.begin() + foundByOffsets[i], foundBy.begin() + foundByOffsets[i + 1]);
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+};
+
+#endif
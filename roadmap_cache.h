@@ -0,0 +1,125 @@
+#ifndef ROADMAP_CACHE_H
+#define ROADMAP_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+#include "roadmap.h"
+
+// Binary roadmap file, so a roadmap built once for a set of obstacles can be reused on later runs
+// Layout, all in native byte order:
+//   RoadmapFileHeader
+//   points       numNodes * 3 floats
+//   edgeOffsets  numNodes + 1 unsigned ints
+//   edgeTargets  numEdges * 2 unsigned ints
+//   edgeCosts    numEdges * 2 floats
+//   edgeIndices  numEdges * 2 unsigned ints
+struct RoadmapFileHeader
+{
+	char magic[4];                   // "PRMC"
+	unsigned int version;
+	unsigned int numNodes;
+	unsigned int numEdges;           // Undirected, so the CSR arrays hold twice this many entries
+	unsigned long long obstacleHash; // ObstacleSet::hash() of the obstacles it was built for
+	unsigned long long settingsHash; // Sampling and connection settings it was built with
+};
+
+enum : unsigned int { ROADMAP_FILE_VERSION = 1 };
+
+inline size_t roadmapFileSize(unsigned int numNodes, unsigned int numEdges)
+{
+	return sizeof(RoadmapFileHeader) + (size_t)numNodes * sizeof(glm::vec3) + ((size_t)numNodes + 1) * sizeof(unsigned int)
+		+ (size_t)numEdges * 2 * (2 * sizeof(unsigned int) + sizeof(float));
+}
+
+inline bool saveRoadmapFile(const Roadmap &roadmap, const std::string &fileName, unsigned long long obstacleHash, unsigned long long settingsHash)
+{
+	std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	RoadmapFileHeader header;
+	memcpy(header.magic, "PRMC", 4);
+	header.version = ROADMAP_FILE_VERSION;
+	header.numNodes = roadmap.numNodes();
+	header.numEdges = roadmap.numEdges();
+	header.obstacleHash = obstacleHash;
+	header.settingsHash = settingsHash;
+
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(roadmap.points.data()), roadmap.points.size() * sizeof(glm::vec3));
+	file.write(reinterpret_cast<const char *>(roadmap.edgeOffsets.data()), roadmap.edgeOffsets.size() * sizeof(unsigned int));
+	file.write(reinterpret_cast<const char *>(roadmap.edgeTargets.data()), roadmap.edgeTargets.size() * sizeof(unsigned int));
+	file.write(reinterpret_cast<const char *>(roadmap.edgeCosts.data()), roadmap.edgeCosts.size() * sizeof(float));
+	file.write(reinterpret_cast<const char *>(roadmap.edgeIndices.data()), roadmap.edgeIndices.size() * sizeof(unsigned int));
+	return file.good();
+}
+
+// Copy each array of a mapped file straight into the roadmap, advancing the read pointer
+template <typename T>
+inline void readArray(const unsigned char *&at, std::vector<T> &array, size_t count)
+{
+	array.resize(count);
+	if (count > 0)
+		memcpy(array.data(), at, count * sizeof(T));
+	at += count * sizeof(T);
+}
+
+// Replace the roadmap with the one in fileName
+// Returns false, leaving the roadmap alone, if the file is missing, malformed or was built for other obstacles or settings
+// The file is mapped rather than read, so each array is a single copy out of the page cache with no parsing
+inline bool loadRoadmapFile(Roadmap &roadmap, const std::string &fileName, unsigned long long obstacleHash, unsigned long long settingsHash)
+{
+	MappedFile file;
+	if (!file.open(fileName) || file.size() < sizeof(RoadmapFileHeader))
+		return false;
+
+	RoadmapFileHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, "PRMC", 4) != 0 || header.version != ROADMAP_FILE_VERSION || header.obstacleHash != obstacleHash)
+		return false;
+	if (header.settingsHash != settingsHash)
+		return false;
+	if (file.size() != roadmapFileSize(header.numNodes, header.numEdges))
+		return false;
+
+	const unsigned char *at = file.data() + sizeof(header);
+	Roadmap loaded;
+	loaded.connection = roadmap.connection;
+	loaded.connectK = roadmap.connectK;
+	loaded.connectRadius = roadmap.connectRadius;
+	loaded.lazy = roadmap.lazy;
+	size_t numEntries = (size_t)header.numEdges * 2;
+	readArray(at, loaded.points, header.numNodes);
+	readArray(at, loaded.edgeOffsets, (size_t)header.numNodes + 1);
+	readArray(at, loaded.edgeTargets, numEntries);
+	readArray(at, loaded.edgeCosts, numEntries);
+	readArray(at, loaded.edgeIndices, numEntries);
+
+	// Don't trust offsets or targets that would index out of bounds
+	if (loaded.edgeOffsets[0] != 0 || loaded.edgeOffsets[header.numNodes] != numEntries)
+		return false;
+	for (unsigned int i = 0; i < header.numNodes; i++)
+	{
+		if (loaded.edgeOffsets[i] > loaded.edgeOffsets[i + 1])
+			return false;
+	}
+	for (size_t e = 0; e < numEntries; e++)
+	{
+		if (loaded.edgeTargets[e] >= header.numNodes || loaded.edgeIndices[e] >= header.numNodes)
+			return false;
+	}
+
+	// Which edges a lazy roadmap has tested isn't saved, so start over
+	loaded.edgeChecked.assign(numEntries, loaded.lazy ? 0 : 1);
+	roadmap = std::move(loaded);
+	return true;
+}
+
+#endif
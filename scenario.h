@@ -0,0 +1,104 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <glm/glm.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+#include "planner.h"
+
+// The crowd and obstacles the app starts with
+inline void loadDefaultScenario(MotionPlanner &planner)
+{
+	/*
+	planner.addAgent(glm::vec3(15.0f, 0.0f, 10.0f), glm::vec3(-15.0f, 0.0f, -10.0f));
+	planner.addAgent(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, -10.0f));
+	planner.addAgent(glm::vec3(10.0f, 0.0f, -5.0f), glm::vec3(-10.0f, 0.0f, 5.0f));
+	planner.addAgent(glm::vec3(-15.0f, 0.0f, 5.0f), glm::vec3(19.0f, 0.0f, 13.0f));
+	planner.addAgent(glm::vec3(13.0f, 0.0f, 5.0f), glm::vec3(-7.0f, 0.0f, -11.0f));
+	planner.addAgent(glm::vec3(-19.0f, 0.0f, -1.0f), glm::vec3(13.0f, 0.0f, 8.0f));
+	planner.addAgent(glm::vec3(-15.0f, 0.0f, -10.0f), glm::vec3(15.0f, 0.0f, 10.0f));
+	planner.addAgent(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(0.0f, 0.0f, 10.0f));
+	planner.addAgent(glm::vec3(-10.0f, 0.0f, 5.0f), glm::vec3(10.0f, 0.0f, -5.0f));
+	planner.addAgent(glm::vec3(10.0f, 0.0f, 5.0f), glm::vec3(-9.0f, 0.0f, -13.0f));
+	planner.addAgent(glm::vec3(-3.0f, 0.0f, -2.0f), glm::vec3(3.0f, 0.0f, -12.0f));
+	planner.addAgent(glm::vec3(19.0f, 0.0f, 1.0f), glm::vec3(-13.0f, 0.0f, -8.0f));
+	*/
+	planner.addAgent(glm::vec3(15.0f, 0.0f, 10.0f), glm::vec3(-15.0f, 0.0f, 10.0f));
+	planner.addAgent(glm::vec3(15.0f, 0.0f, 9.0f), glm::vec3(-15.0f, 0.0f, 9.0f));
+	planner.addAgent(glm::vec3(15.0f, 0.0f, 8.0f), glm::vec3(-15.0f, 0.0f, 8.0f));
+	planner.addAgent(glm::vec3(15.0f, 0.0f, 7.0f), glm::vec3(-15.0f, 0.0f, 7.0f));
+	planner.addAgent(glm::vec3(-15.0f, 0.0f, 10.2f), glm::vec3(15.0f, 0.0f, 10.2f));
+	planner.addAgent(glm::vec3(-15.0f, 0.0f, 9.2f), glm::vec3(15.0f, 0.0f, 9.2f));
+	planner.addAgent(glm::vec3(-15.0f, 0.0f, 8.2f), glm::vec3(15.0f, 0.0f, 8.2f));
+	planner.addAgent(glm::vec3(-15.0f, 0.0f, 7.2f), glm::vec3(15.0f, 0.0f, 7.2f));
+
+	planner.addAgent(glm::vec3(16.0f, 0.0f, 10.0f), glm::vec3(-16.0f, 0.0f, 10.0f));
+	planner.addAgent(glm::vec3(16.0f, 0.0f, 9.0f), glm::vec3(-16.0f, 0.0f, 9.0f));
+	planner.addAgent(glm::vec3(16.0f, 0.0f, 8.0f), glm::vec3(-16.0f, 0.0f, 8.0f));
+	planner.addAgent(glm::vec3(16.0f, 0.0f, 7.0f), glm::vec3(-16.0f, 0.0f, 7.0f));
+	planner.addAgent(glm::vec3(-16.0f, 0.0f, 10.2f), glm::vec3(16.0f, 0.0f, 10.2f));
+	planner.addAgent(glm::vec3(-16.0f, 0.0f, 9.2f), glm::vec3(16.0f, 0.0f, 9.2f));
+	planner.addAgent(glm::vec3(-16.0f, 0.0f, 8.2f), glm::vec3(16.0f, 0.0f, 8.2f));
+	planner.addAgent(glm::vec3(-16.0f, 0.0f, 7.2f), glm::vec3(16.0f, 0.0f, 7.2f));
+
+	planner.obstacles.addBarrel(glm::vec3(0.0f, 0.0f, 0.0f));
+	planner.obstacles.addBarrel(glm::vec3(3.0f, 0.0f, 1.0f));
+	planner.obstacles.addBarrel(glm::vec3(-12.0f, 0.0f, 2.0f));
+	planner.obstacles.addBarrel(glm::vec3(19.0f, 0.0f, -4.0f));
+	planner.obstacles.addBarrel(glm::vec3(0.0f, 0.0f, -16.0f));
+	planner.obstacles.addBarrel(glm::vec3(8.0f, 0.0f, 2.0f));
+
+	planner.obstacles.addCar(glm::vec3(10.0f, 0.0f, 0.0f), false);
+	planner.obstacles.addCar(glm::vec3(-15.0f, 0.0f, -6.0f), false);
+	planner.obstacles.addCar(glm::vec3(7.0f, 0.0f, 16.0f), false);
+}
+
+// Random point in the map that isn't inside an obstacle (uses rand, so seed with srand)
+inline glm::vec3 randomFreePoint(const MotionPlanner &planner)
+{
+	while (true)
+	{
+		float x = (static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 0.5f) * planner.mapSize;
+		float z = (static_cast <float> (rand()) / static_cast <float> (RAND_MAX) - 0.5f) * planner.mapSize;
+		glm::vec2 p = glm::vec2(x, z);
+		if (!planner.obstacles.collidesWithObs(p, p + glm::vec2(0.001f, 0.0f)))
+			return glm::vec3(x, 0.0f, z);
+	}
+}
+
+// Scatter obstacles uniformly over the map, for scaling tests
+inline void addRandomObstacles(MotionPlanner &planner, int numBarrels, int numCars)
+{
+	for (int i = 0; i < numBarrels; i++)
+		planner.obstacles.addBarrel(randomFreePoint(planner));
+	for (int i = 0; i < numCars; i++)
+		planner.obstacles.addCar(randomFreePoint(planner), false);
+}
+
+// Add numAgents agents with random start and goal points, for scaling tests
+inline void addRandomCrowd(MotionPlanner &planner, int numAgents)
+{
+	for (int i = 0; i < numAgents; i++)
+	{
+		glm::vec3 start = randomFreePoint(planner);
+		glm::vec3 goal = randomFreePoint(planner);
+		planner.addAgent(start, goal);
+	}
+}
+
+// Add numAgents agents with random start points, each heading for one of numExits random goal points
+inline void addExitCrowd(MotionPlanner &planner, int numAgents, int numExits)
+{
+	std::vector<glm::vec3> exits;
+	for (int i = 0; i < numExits; i++)
+		exits.push_back(randomFreePoint(planner));
+	for (int i = 0; i < numAgents; i++)
+	{
+		glm::vec3 start = randomFreePoint(planner);
+		planner.addAgent(start, exits[i % numExits]);
+	}
+}
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef SCENARIO_FILE_H
+#define SCENARIO_FILE_H
+
+#include <glm/glm.hpp>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "planner.h"
+#include "roadmap_cache.h"
+
+// Scenario files, so crowds and obstacles are loaded at run time instead of compiled in
+// Text format, one item per line, coordinates are x z on the ground plane and # starts a comment:
+//   map SIZE
+//   agent START_X START_Z GOAL_X GOAL_Z
+//   barrel X Z
+//   car X Z [ROTATED]   (ROTATED is 0 or 1, default 0)
+// Binary format, all in native byte order:
+//   ScenarioFileHeader
+//   agents   numAgents * 4 floats (start x z, goal x z)
+//   barrels  numBarrels * 2 floats
+//   cars     numCars * 2 floats, then numCars bytes (1 if rotated)
+// Either kind adds to whatever the planner already holds, so load into a fresh planner to get just the file
+struct ScenarioFileHeader
+{
+	char magic[4]; // "SCNB"
+	unsigned int version;
+	float mapSize;
+	unsigned int numAgents;
+	unsigned int numBarrels;
+	unsigned int numCars;
+};
+
+enum : unsigned int { SCENARIO_FILE_VERSION = 1 };
+
+inline size_t scenarioFileSize(unsigned int numAgents, unsigned int numBarrels, unsigned int numCars)
+{
+	return sizeof(ScenarioFileHeader) + (size_t)numAgents * 4 * sizeof(float) + (size_t)numBarrels * 2 * sizeof(float)
+		+ (size_t)numCars * (2 * sizeof(float) + 1);
+}
+
+// Read up to maxCount numbers from at, returning how many were read
+// Returns -1 if anything other than whitespace or a comment follows them
+inline int readScenarioValues(const char *at, float *values, int maxCount)
+{
+	int count = 0;
+	while (true)
+	{
+		while (isspace((unsigned char)*at))
+			at++;
+		if (*at == '\0' || *at == '#')
+			return count;
+		if (count == maxCount)
+			return -1;
+		char *end;
+		values[count] = strtof(at, &end);
+		if (end == at)
+			return -1;
+		at = end;
+		count++;
+	}
+}
+
+// Obstacles are appended straight to the obstacle lists and bucketed once at the end, rather than through
+// addBarrel/addCar, so loading thousands of them doesn't keep rebuilding the broad phase grid
+inline bool loadScenarioText(MotionPlanner &planner, const std::string &fileName, std::string &error)
+{
+	std::ifstream file(fileName.c_str());
+	if (!file)
+	{
+		error = "Can't open " + fileName;
+		return false;
+	}
+
+	ObstacleSet &obstacles = planner.obstacles;
+	std::string line;
+	unsigned int lineNumber = 0;
+	bool ok = true;
+	while (ok && std::getline(file, line))
+	{
+		lineNumber++;
+		const char *at = line.c_str();
+		while (isspace((unsigned char)*at))
+			at++;
+		if (*at == '\0' || *at == '#')
+			continue;
+
+		const char *word = at;
+		while (*at != '\0' && !isspace((unsigned char)*at))
+			at++;
+		size_t length = at - word;
+
+		float v[4];
+		int count = readScenarioValues(at, v, 4);
+		if (length == 3 && strncmp(word, "map", 3) == 0 && count == 1 && v[0] > 0.0f)
+			planner.mapSize = v[0];
+		else if (length == 5 && strncmp(word, "agent", 5) == 0 && count == 4)
+			planner.addAgent(glm::vec3(v[0], 0.0f, v[1]), glm::vec3(v[2], 0.0f, v[3]));
+		else if (length == 6 && strncmp(word, "barrel", 6) == 0 && count == 2)
+			obstacles.barrelPos.push_back(glm::vec3(v[0], 0.0f, v[1]));
+		else if (length == 3 && strncmp(word, "car", 3) == 0 && (count == 2 || count == 3))
+		{
+			obstacles.carPos.push_back(glm::vec3(v[0], 0.0f, v[1]));
+			obstacles.carRot.push_back(count == 3 && v[2] != 0.0f);
+		}
+		else
+		{
+			error = fileName + ":" + std::to_string(lineNumber) + ": can't read \"" + line + "\"";
+			ok = false;
+		}
+	}
+	obstacles.rebuildGrid();
+	return ok;
+}
+
+// The file is mapped and checked against the sizes in its header before anything is added to the planner
+inline bool loadScenarioBinary(MotionPlanner &planner, const std::string &fileName, std::string &error)
+{
+	MappedFile file;
+	if (!file.open(fileName) || file.size() < sizeof(ScenarioFileHeader))
+	{
+		error = "Can't open " + fileName;
+		return false;
+	}
+
+	ScenarioFileHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, "SCNB", 4) != 0 || header.version != SCENARIO_FILE_VERSION)
+	{
+		error = fileName + " isn't a version " + std::to_string(SCENARIO_FILE_VERSION) + " binary scenario";
+		return false;
+	}
+	if (file.size() != scenarioFileSize(header.numAgents, header.numBarrels, header.numCars))
+	{
+		error = fileName + " is the wrong size for its header";
+		return false;
+	}
+
+	const unsigned char *at = file.data() + sizeof(header);
+	std::vector<float> values;
+	if (header.mapSize > 0.0f)
+		planner.mapSize = header.mapSize;
+
+	readArray(at, values, (size_t)header.numAgents * 4);
+	for (unsigned int i = 0; i < header.numAgents; i++)
+	{
+		const float *v = &values[i * 4];
+		planner.addAgent(glm::vec3(v[0], 0.0f, v[1]), glm::vec3(v[2], 0.0f, v[3]));
+	}
+
+	ObstacleSet &obstacles = planner.obstacles;
+	readArray(at, values, (size_t)header.numBarrels * 2);
+	for (unsigned int k = 0; k < header.numBarrels; k++)
+		obstacles.barrelPos.push_back(glm::vec3(values[k * 2], 0.0f, values[k * 2 + 1]));
+
+	readArray(at, values, (size_t)header.numCars * 2);
+	for (unsigned int k = 0; k < header.numCars; k++)
+	{
+		obstacles.carPos.push_back(glm::vec3(values[k * 2], 0.0f, values[k * 2 + 1]));
+		obstacles.carRot.push_back(at[k] != 0);
+	}
+	obstacles.rebuildGrid();
+	return true;
+}
+
+// Load either kind, telling them apart by the binary magic
+inline bool loadScenarioFile(MotionPlanner &planner, const std::string &fileName, std::string &error)
+{
+	char magic[4] = {};
+	{
+		std::ifstream file(fileName.c_str(), std::ios::binary);
+		if (!file)
+		{
+			error = "Can't open " + fileName;
+			return false;
+		}
+		file.read(magic, 4);
+	}
+	if (memcmp(magic, "SCNB", 4) == 0)
+		return loadScenarioBinary(planner, fileName, error);
+	return loadScenarioText(planner, fileName, error);
+}
+
+// Save the planner's map, agents and obstacles. Agents start from where they are now
+inline bool saveScenarioFile(const MotionPlanner &planner, const std::string &fileName, bool binary)
+{
+	const CrowdSimulation &crowd = planner.crowd;
+	const ObstacleSet &obstacles = planner.obstacles;
+	const std::vector<glm::vec3> &goals = crowd.goals();
+	if (!binary)
+	{
+		std::ofstream file(fileName.c_str(), std::ios::trunc);
+		if (!file)
+			return false;
+		file.precision(9);
+		file << "map " << planner.mapSize << "\n";
+		for (unsigned int i = 0; i < crowd.numAgents(); i++)
+		{
+			glm::vec3 start = crowd.position(i);
+			file << "agent " << start[0] << " " << start[2] << " " << goals[i][0] << " " << goals[i][2] << "\n";
+		}
+		for (unsigned int k = 0; k < obstacles.barrelPos.size(); k++)
+			file << "barrel " << obstacles.barrelPos[k][0] << " " << obstacles.barrelPos[k][2] << "\n";
+		for (unsigned int k = 0; k < obstacles.carPos.size(); k++)
+			file << "car " << obstacles.carPos[k][0] << " " << obstacles.carPos[k][2] << " " << (obstacles.carRot[k] ? 1 : 0) << "\n";
+		return file.good();
+	}
+
+	std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	ScenarioFileHeader header;
+	memcpy(header.magic, "SCNB", 4);
+	header.version = SCENARIO_FILE_VERSION;
+	header.mapSize = planner.mapSize;
+	header.numAgents = crowd.numAgents();
+	header.numBarrels = obstacles.barrelPos.size();
+	header.numCars = obstacles.carPos.size();
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	std::vector<float> values;
+	for (unsigned int i = 0; i < crowd.numAgents(); i++)
+	{
+		glm::vec3 start = crowd.position(i);
+		values.push_back(start[0]);
+		values.push_back(start[2]);
+		values.push_back(goals[i][0]);
+		values.push_back(goals[i][2]);
+	}
+	for (unsigned int k = 0; k < obstacles.barrelPos.size(); k++)
+	{
+		values.push_back(obstacles.barrelPos[k][0]);
+		values.push_back(obstacles.barrelPos[k][2]);
+	}
+	for (unsigned int k = 0; k < obstacles.carPos.size(); k++)
+	{
+		values.push_back(obstacles.carPos[k][0]);
+		values.push_back(obstacles.carPos[k][2]);
+	}
+	std::vector<unsigned char> rotated(obstacles.carRot.begin(), obstacles.carRot.end());
+	if (!values.empty())
+		file.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(float));
+	if (!rotated.empty())
+		file.write(reinterpret_cast<const char *>(rotated.data()), rotated.size());
+	return file.good();
+}
+
+#endif
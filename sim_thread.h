@@ -0,0 +1,136 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "simulation.h"
+#include "triple_buffer.h"
+
+// Agent positions after one simulation step and the step before it, for drawing in between the two
+struct CrowdSnapshot
+{
+	std::vector<float> prevX, prevZ;
+	std::vector<float> x, z;
+	unsigned long long step = 0;
+	std::chrono::steady_clock::time_point time; // When the step was published
+
+	unsigned int numAgents() const { return x.size(); }
+
+	// Position t of the way from the previous step to this one
+	glm::vec3 position(unsigned int agent, float t) const
+	{
+		return glm::vec3(prevX[agent] + (x[agent] - prevX[agent]) * t, 0.0f, prevZ[agent] + (z[agent] - prevZ[agent]) * t);
+	}
+};
+
+// Steps a crowd on its own thread at the crowd's fixed timeStep, independent of the render rate
+// Each step is published as a CrowdSnapshot through a triple buffer, so the renderer never waits on the simulation
+// and a slow frame never changes the length of a step. Anything else that touches the crowd (planning, adding
+// agents, repairing paths) has to go through edit so it doesn't race a step
+class SimulationThread
+{
+public:
+	SimulationThread(CrowdSimulation &crowd) : crowd(crowd)
+	{
+	}
+
+	~SimulationThread() { stop(); }
+
+	SimulationThread(const SimulationThread &) = delete;
+	SimulationThread &operator=(const SimulationThread &) = delete;
+
+	void start()
+	{
+		if (thread.joinable())
+			return;
+		quit = false;
+		edit([] {});
+		thread = std::thread(&SimulationThread::run, this);
+	}
+
+	void stop()
+	{
+		quit = true;
+		if (thread.joinable())
+			thread.join();
+	}
+
+	// Steps are only taken while running, the thread keeps its schedule either way
+	void setRunning(bool run) { running = run; }
+	bool isRunning() const { return running; }
+
+	// Run f with no step in progress, then publish the crowd as it is afterwards
+	template<typename F>
+	void edit(F f)
+	{
+		std::lock_guard<std::mutex> lock(crowdMutex);
+		f();
+		publish(false);
+	}
+
+	// Render thread side: pick up the newest snapshot and return how far to draw between its two steps
+	const CrowdSnapshot &latest(float &t)
+	{
+		snapshots.update();
+		const CrowdSnapshot &snapshot = snapshots.front();
+		float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot.time).count();
+		t = std::min(elapsed / crowd.timeStep, 1.0f);
+		return snapshot;
+	}
+
+private:
+	CrowdSimulation &crowd;
+	std::thread thread;
+	std::mutex crowdMutex;
+	std::atomic<bool> quit{ false };
+	std::atomic<bool> running{ false };
+	TripleBuffer<CrowdSnapshot> snapshots;
+
+	void run()
+	{
+		typedef std::chrono::steady_clock Clock;
+		Clock::duration stepLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(crowd.timeStep));
+		Clock::time_point next = Clock::now();
+		while (!quit)
+		{
+			if (running)
+			{
+				std::lock_guard<std::mutex> lock(crowdMutex);
+				crowd.step();
+				publish(true);
+			}
+
+			// Drop time rather than fall further behind after a stall, like CrowdSimulation::advance
+			next += stepLength;
+			Clock::time_point now = Clock::now();
+			if (now - next > stepLength * crowd.maxStepsPerAdvance)
+				next = now;
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	// Copy the crowd into the back snapshot, with the previous step as the starting point if it moved
+	void publish(bool moved)
+	{
+		CrowdSnapshot &snapshot = snapshots.back();
+		const AgentStore &cur = crowd.agents();
+		const AgentStore &prev = moved ? crowd.previousAgents() : cur;
+		unsigned int n = cur.size();
+		snapshot.prevX.assign(prev.x, prev.x + n);
+		snapshot.prevZ.assign(prev.z, prev.z + n);
+		snapshot.x.assign(cur.x, cur.x + n);
+		snapshot.z.assign(cur.z, cur.z + n);
+		snapshot.step = crowd.stepCount();
+		snapshot.time = std::chrono::steady_clock::now();
+		snapshots.publish();
+	}
+};
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "agent_store.h"
+#include "profile.h"
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "ttc_kernel.h"
+
+// Crowd simulation stepped at a fixed rate
+// Agent positions and velocities are double buffered: a step only reads the previous state and each agent only
+// writes its own slot of the next state, so the result doesn't depend on how agents are split between threads
+class CrowdSimulation
+{
+public:
+	float agentRad = 0.49f;
+	float horizon = 20.0f;        // TTC time horizon
+	float timeStep = 1.0f / 60.0f; // Fixed step length in seconds
+	int maxStepsPerAdvance = 8;   // Drop time rather than fall further behind after a slow frame
+	bool useSimd = true;          // Use the vectorised TTC kernel, false for the scalar reference
+	float arrivalRadius = 0.5f;   // How close an agent gets to a waypoint before heading for the next one
+
+	// Steps are split across the pool's threads, the pool must outlive the simulation
+	CrowdSimulation(ThreadPool &pool) : pool(pool)
+	{
+	}
+
+	void addAgent(glm::vec3 start, glm::vec3 goal)
+	{
+		state[cur].push_back(start[0], start[2], 0.0f, 0.0f);
+		state[1 - cur].push_back(start[0], start[2], 0.0f, 0.0f);
+		agentGoals.push_back(goal);
+		nextPathPoint.push_back(glm::vec3(0.0f));
+		paths.push_back(std::vector<glm::vec3>());
+	}
+
+	// Path is stored goal first so the next waypoint can be popped off the back
+	void setPath(unsigned int agent, const std::vector<glm::vec3> &path)
+	{
+		if (path.empty())
+			return;
+		nextPathPoint[agent] = path.back();
+		paths[agent].assign(path.begin(), path.end() - 1);
+	}
+
+	unsigned int waypointsLeft(unsigned int agent) const { return paths[agent].size(); } // Not counting the one being walked to
+	unsigned int numAgents() const { return state[cur].size(); }
+	unsigned int numThreads() const { return pool.size(); }
+	glm::vec3 position(unsigned int agent) const { return glm::vec3(state[cur].x[agent], 0.0f, state[cur].z[agent]); }
+	glm::vec3 velocity(unsigned int agent) const { return glm::vec3(state[cur].vx[agent], 0.0f, state[cur].vz[agent]); }
+	const AgentStore &agents() const { return state[cur]; }
+	const AgentStore &previousAgents() const { return state[1 - cur]; } // The state the last step started from
+	const std::vector<glm::vec3> &goals() const { return agentGoals; }
+	unsigned long long stepCount() const { return steps; }
+
+	// Run as many fixed steps as fit in dt, carrying the remainder over to the next call
+	void advance(float dt)
+	{
+		accumulator += dt;
+		int numSteps = 0;
+		while (accumulator >= timeStep && numSteps < maxStepsPerAdvance)
+		{
+			step();
+			accumulator -= timeStep;
+			numSteps++;
+		}
+		if (numSteps == maxStepsPerAdvance)
+			accumulator = std::min(accumulator, timeStep);
+	}
+
+	// Advance the crowd by exactly one timeStep
+	void step()
+	{
+		PROFILE_SCOPE("crowdStep");
+		unsigned int n = numAgents();
+		const AgentStore &prev = state[cur];
+		broadPhase();
+
+		// Forces only read the previous state, then integration writes the next one
+		forceX.resize(n);
+		forceZ.resize(n);
+		{
+			PROFILE_SCOPE("crowdForces");
+			pool.parallelFor(n, 64, [this](unsigned int begin, unsigned int end)
+			{
+				unsigned long long pairs = 0;
+				for (unsigned int agent = begin; agent < end; agent++)
+					pairs += agentForce(agent);
+				PROFILE_COUNT(COUNTER_TTC_PAIRS, pairs);
+			});
+		}
+		{
+			PROFILE_SCOPE("crowdIntegrate");
+			AgentStore &next = state[1 - cur];
+			pool.parallelFor(n, 4096, [&](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int agent = begin; agent < end; agent++)
+				{
+					next.vx[agent] = prev.vx[agent] + forceX[agent] * timeStep;
+					next.vz[agent] = prev.vz[agent] + forceZ[agent] * timeStep;
+					next.x[agent] = prev.x[agent] + next.vx[agent] * timeStep;
+					next.z[agent] = prev.z[agent] + next.vz[agent] * timeStep;
+				}
+			});
+			PROFILE_COUNT(COUNTER_AGENT_STEPS, n);
+		}
+
+		cur = 1 - cur;
+		steps++;
+	}
+
+private:
+	ThreadPool &pool;
+	SpatialHash agentGrid; // Rebuilt every step for TTC neighbour queries
+	AgentStore bucketed;   // Previous state in agentGrid bucket order
+	std::vector<float> forceX, forceZ; // This step's force on each agent
+	float sensingRadius = 0.0f;
+	float accumulator = 0.0f;
+	unsigned long long steps = 0;
+
+	// Double buffered state, cur is the latest completed step
+	int cur = 0;
+	AgentStore state[2];
+
+	// Per agent state only ever touched by that agent's update
+	std::vector<glm::vec3> agentGoals;
+	std::vector<glm::vec3> nextPathPoint;
+	std::vector<std::vector<glm::vec3>> paths;
+
+	// Bucket the previous state for the TTC neighbour queries
+	void broadPhase()
+	{
+		PROFILE_SCOPE("crowdBroadPhase");
+		unsigned int n = numAgents();
+		const AgentStore &prev = state[cur];
+
+		float maxSpeed2 = 0.0f;
+		for (unsigned int i = 0; i < n; i++)
+			maxSpeed2 = std::max(maxSpeed2, prev.vx[i] * prev.vx[i] + prev.vz[i] * prev.vz[i]);
+
+		// Two agents further apart than this can't collide within the horizon, so their TTC force is 0
+		sensingRadius = (agentRad * 2.0f + 2.0f * std::sqrt(maxSpeed2) * horizon) * 1.001f;
+		agentGrid.build(prev.x, prev.z, n, sensingRadius);
+
+		// Copy agents into bucket order so each bucket is a contiguous run the TTC kernel can stream through
+		const std::vector<unsigned int> &order = agentGrid.order();
+		bucketed.resize(n);
+		for (unsigned int k = 0; k < n; k++)
+		{
+			unsigned int i = order[k];
+			bucketed.x[k] = prev.x[i];
+			bucketed.z[k] = prev.z[i];
+			bucketed.vx[k] = prev.vx[i];
+			bucketed.vz[k] = prev.vz[i];
+		}
+	}
+
+	// Move the agent on to its next waypoint if it has reached this one, and store its goal plus TTC force
+	// Returns the number of agents streamed through the TTC kernel
+	unsigned int agentForce(unsigned int agent)
+	{
+		const AgentStore &prev = state[cur];
+		float px = prev.x[agent], pz = prev.z[agent];
+		float pvx = prev.vx[agent], pvz = prev.vz[agent];
+
+		// Paths are smoothed when planned, so each waypoint only needs reaching before moving on to the next
+		if (!paths[agent].empty())
+		{
+			float dx = nextPathPoint[agent][0] - px, dz = nextPathPoint[agent][2] - pz;
+			if (dx * dx + dz * dz < arrivalRadius * arrivalRadius)
+			{
+				nextPathPoint[agent] = paths[agent].back();
+				paths[agent].pop_back();
+			}
+		}
+
+		// Now get a goal force
+		glm::vec2 offset = glm::vec2(nextPathPoint[agent][0] - px, nextPathPoint[agent][2] - pz);
+		glm::vec2 goalVel;
+		if (offset[0] == offset[0]) //If offset is defined
+		{
+			if (glm::length(offset) > 1.0f)
+			{
+				offset = glm::normalize(offset);
+				goalVel = 3.0f * offset;
+			}
+			else
+				goalVel = offset;
+		}
+		else
+		{
+			goalVel = glm::vec2(0.0f);
+		}
+
+		glm::vec2 force = 2.0f * (goalVel - glm::vec2(pvx, pvz));
+
+		// Now need TTC force from other agents
+		// Only agents in neighbouring cells can give a non-zero force, and the agent itself gives zero
+		TTCParams params = { agentRad, horizon };
+		unsigned int pairs = 0;
+		agentGrid.forEachBucket(px, pz, [&](unsigned int begin, unsigned int end)
+		{
+			pairs += end - begin;
+			if (useSimd)
+				force = force + ttcForceSumSimd(bucketed, begin, end, px, pz, pvx, pvz, params);
+			else
+				force = force + ttcForceSumScalar(bucketed, begin, end, px, pz, pvx, pvz, params);
+		});
+
+		forceX[agent] = force[0];
+		forceZ[agent] = force[1];
+		return pairs;
+	}
+};
+
+#endif
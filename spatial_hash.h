@@ -0,0 +1,97 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cmath>
+#include <vector>
+
+// Uniform grid over the xz plane, stored as a hash table of cells so the map doesn't need bounds
+// Rebuilt from scratch every step with a counting sort, so build is O(N)
+class SpatialHash
+{
+public:
+	// Bucket the n positions (x[i], z[i]) into cells of size cellSize
+	void build(const float *x, const float *z, unsigned int n, float cellSize)
+	{
+		this->cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+		invCellSize = 1.0f / this->cellSize;
+
+		// Power of two table at least twice the number of agents
+		numBuckets = 16;
+		while (numBuckets < 2 * n)
+			numBuckets *= 2;
+
+		cellX.resize(n);
+		cellZ.resize(n);
+		bucketStart.assign(numBuckets + 1, 0);
+		sorted.resize(n);
+
+		// Count agents per bucket
+		std::vector<unsigned int> bucketOf(n);
+		for (unsigned int i = 0; i < n; i++)
+		{
+			cellX[i] = cellCoord(x[i]);
+			cellZ[i] = cellCoord(z[i]);
+			bucketOf[i] = bucket(cellX[i], cellZ[i]);
+			bucketStart[bucketOf[i] + 1]++;
+		}
+		for (unsigned int b = 0; b < numBuckets; b++)
+			bucketStart[b + 1] += bucketStart[b];
+
+		// Scatter, keeping agents in index order within a bucket
+		std::vector<unsigned int> fill(bucketStart.begin(), bucketStart.end() - 1);
+		for (unsigned int i = 0; i < n; i++)
+			sorted[fill[bucketOf[i]]++] = i;
+	}
+
+	// Call f(begin, end) once for each distinct bucket covering the 3x3 cells around (px, pz)
+	// begin and end index into order(), and a bucket can also hold agents from unrelated cells
+	template <typename F>
+	void forEachBucket(float px, float pz, F f) const
+	{
+		int cx = cellCoord(px);
+		int cz = cellCoord(pz);
+		unsigned int seen[9];
+		unsigned int numSeen = 0;
+		for (int dz = -1; dz <= 1; dz++)
+		{
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				unsigned int b = bucket(cx + dx, cz + dz);
+				bool repeat = false;
+				for (unsigned int k = 0; k < numSeen; k++)
+					repeat = repeat || seen[k] == b;
+				if (repeat)
+					continue;
+				seen[numSeen++] = b;
+				if (bucketStart[b] < bucketStart[b + 1])
+					f(bucketStart[b], bucketStart[b + 1]);
+			}
+		}
+	}
+
+	// Agent indices grouped by bucket
+	const std::vector<unsigned int> &order() const { return sorted; }
+
+	float getCellSize() const { return cellSize; }
+
+private:
+	float cellSize = 1.0f;
+	float invCellSize = 1.0f;
+	unsigned int numBuckets = 0;
+	std::vector<int> cellX, cellZ;          // Cell of each agent
+	std::vector<unsigned int> bucketStart;  // Start of each bucket in sorted
+	std::vector<unsigned int> sorted;       // Agent indices grouped by bucket
+
+	int cellCoord(float x) const
+	{
+		return (int)std::floor(x * invCellSize);
+	}
+
+	unsigned int bucket(int x, int z) const
+	{
+		unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u;
+		return h & (numBuckets - 1);
+	}
+};
+
+#endif
@@ -0,0 +1,361 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hash.h"
+#include "mapped_file.h"
+
+// Texture cache file, a source image decoded once along with its whole mip chain so later launches skip decoding
+// Layout, all in native byte order:
+//   TextureCacheHeader
+//   numLevels levels, level i being max(1, width >> i) by max(1, height >> i) texels of components bytes, rows unpadded
+struct TextureCacheHeader
+{
+	char magic[4];                 // "TEXC"
+	unsigned int version;
+	unsigned long long sourceHash; // Of the image file it was decoded from
+	unsigned int width;
+	unsigned int height;
+	unsigned int components;       // 1 to 4 bytes per texel
+	unsigned int numLevels;
+};
+
+enum : unsigned int { TEXTURE_CACHE_VERSION = 1 };
+
+inline unsigned int mipLevelCount(unsigned int width, unsigned int height)
+{
+	unsigned int levels = 1;
+	for (unsigned int size = std::max(width, height); size > 1; size >>= 1)
+		levels++;
+	return levels;
+}
+
+inline size_t mipLevelSize(unsigned int width, unsigned int height, unsigned int components, unsigned int level)
+{
+	return (size_t)std::max(1u, width >> level) * std::max(1u, height >> level) * components;
+}
+
+inline size_t mipChainSize(unsigned int width, unsigned int height, unsigned int components, unsigned int numLevels)
+{
+	size_t size = 0;
+	for (unsigned int level = 0; level < numLevels; level++)
+		size += mipLevelSize(width, height, components, level);
+	return size;
+}
+
+// Halve a level with a 2x2 box filter, repeating the last row or column of odd sized levels
+inline void downsampleLevel(const unsigned char *src, unsigned int width, unsigned int height, unsigned int components, unsigned char *dst)
+{
+	unsigned int dstWidth = std::max(1u, width >> 1), dstHeight = std::max(1u, height >> 1);
+	for (unsigned int y = 0; y < dstHeight; y++)
+	{
+		const unsigned char *row0 = src + (size_t)std::min(2 * y, height - 1) * width * components;
+		const unsigned char *row1 = src + (size_t)std::min(2 * y + 1, height - 1) * width * components;
+		for (unsigned int x = 0; x < dstWidth; x++)
+		{
+			unsigned int x0 = std::min(2 * x, width - 1) * components, x1 = std::min(2 * x + 1, width - 1) * components;
+			for (unsigned int c = 0; c < components; c++)
+				*dst++ = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+		}
+	}
+}
+
+inline bool saveTextureCache(const std::string &fileName, const TextureCacheHeader &header, const unsigned char *texels)
+{
+	std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(texels), mipChainSize(header.width, header.height, header.components, header.numLevels));
+	return file.good();
+}
+
+// Map fileName and read its header, returning false if it's missing, malformed or was decoded from another source
+// The levels follow the header in file and stay valid while it's open
+inline bool loadTextureCache(MappedFile &file, const std::string &fileName, unsigned long long sourceHash, TextureCacheHeader &header)
+{
+	if (!file.open(fileName) || file.size() < sizeof(TextureCacheHeader))
+		return false;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, "TEXC", 4) != 0 || header.version != TEXTURE_CACHE_VERSION || header.sourceHash != sourceHash)
+		return false;
+	if (header.width == 0 || header.height == 0 || header.components < 1 || header.components > 4
+		|| header.numLevels != mipLevelCount(header.width, header.height))
+		return false;
+	return file.size() == sizeof(header) + mipChainSize(header.width, header.height, header.components, header.numLevels);
+}
+
+// Decodes image files on worker threads while the main thread gets on with other loading, then uploads each through
+// a pixel buffer object as it finishes. With the cache on, every image is decoded once into FILE.texcache next to it,
+// mips included, and later launches just map that
+// request and finish make GL calls so belong on the thread with the context
+class TextureLoader
+{
+public:
+	explicit TextureLoader(bool useCache = true, unsigned int numThreads = 0) : useCache(useCache)
+	{
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int i = 0; i < numThreads; i++)
+			workers.push_back(std::thread(&TextureLoader::workerLoop, this));
+	}
+
+	// Images still queued are dropped, their textures stay empty
+	~TextureLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		workReady.notify_all();
+		for (unsigned int i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+
+	TextureLoader(const TextureLoader &) = delete;
+	TextureLoader &operator=(const TextureLoader &) = delete;
+
+	// Texture name for the image in fileName, which holds nothing until a finish() after this
+	// Asking for a file again gives back the same texture without decoding it twice
+	unsigned int request(const std::string &fileName)
+	{
+		std::map<std::string, unsigned int>::iterator found = textures.find(fileName);
+		if (found != textures.end())
+			return found->second;
+
+		unsigned int texture = 0;
+		glGenTextures(1, &texture);
+		textures[fileName] = texture;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(Job{ fileName, texture });
+			outstanding++;
+		}
+		workReady.notify_one();
+		return texture;
+	}
+
+	// Upload images in the order they finish decoding until every one requested so far is on the GPU
+	void finish()
+	{
+		glGenBuffers(1, &pixelBuffer);
+		while (true)
+		{
+			std::vector<Decoded> ready;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				decodedReady.wait(lock, [this] { return outstanding == 0 || !decoded.empty(); });
+				if (decoded.empty())
+					break;
+				ready.swap(decoded);
+				outstanding -= ready.size();
+			}
+			for (unsigned int i = 0; i < ready.size(); i++)
+				upload(ready[i]);
+		}
+		glDeleteBuffers(1, &pixelBuffer);
+		pixelBuffer = 0;
+	}
+
+private:
+	struct Job
+	{
+		std::string fileName;
+		unsigned int texture;
+	};
+
+	struct StbiFree
+	{
+		void operator()(unsigned char *pixels) const { stbi_image_free(pixels); }
+	};
+
+	struct Decoded
+	{
+		std::string fileName;
+		unsigned int texture = 0;
+		unsigned int width = 0, height = 0, components = 0, numLevels = 0;
+		const unsigned char *texels = nullptr;                // numLevels levels back to back, null if it failed
+		std::unique_ptr<MappedFile> cache;                    // Owns texels when they came from the cache
+		std::vector<unsigned char> chain;                     // Or when the mips were made here
+		std::unique_ptr<unsigned char, StbiFree> pixels;      // Or when there's only the decoded image
+	};
+
+	bool useCache;
+	std::vector<std::thread> workers;
+	std::map<std::string, unsigned int> textures; // Every file requested, main thread only
+	unsigned int pixelBuffer = 0;
+
+	std::mutex mutex;
+	std::condition_variable workReady, decodedReady;
+	std::deque<Job> queue;
+	std::vector<Decoded> decoded;
+	unsigned int outstanding = 0; // Requested but not yet taken by finish
+	bool quit = false;
+
+	void workerLoop()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workReady.wait(lock, [this] { return quit || !queue.empty(); });
+				if (quit)
+					return;
+				job = queue.front();
+				queue.pop_front();
+			}
+
+			Decoded result = decode(job);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				decoded.push_back(std::move(result));
+			}
+			decodedReady.notify_one();
+		}
+	}
+
+	// Runs on a worker. stbi is safe to call from several threads as long as nobody changes its global settings
+	// (stbi_set_flip_vertically_on_load and friends) meanwhile
+	Decoded decode(const Job &job)
+	{
+		Decoded result;
+		result.fileName = job.fileName;
+		result.texture = job.texture;
+
+		MappedFile source;
+		if (!source.open(job.fileName))
+			return result;
+
+		std::string cacheName = job.fileName + ".texcache";
+		unsigned long long sourceHash = FNV_OFFSET_BASIS;
+		if (useCache)
+		{
+			hashBytes(sourceHash, source.data(), source.size());
+			std::unique_ptr<MappedFile> cache(new MappedFile());
+			TextureCacheHeader header;
+			if (loadTextureCache(*cache, cacheName, sourceHash, header))
+			{
+				result.width = header.width;
+				result.height = header.height;
+				result.components = header.components;
+				result.numLevels = header.numLevels;
+				result.texels = cache->data() + sizeof(header);
+				result.cache = std::move(cache);
+				return result;
+			}
+		}
+
+		int width, height, components;
+		unsigned char *pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &components, 0);
+		if (!pixels)
+			return result;
+		result.width = width;
+		result.height = height;
+		result.components = components;
+		result.pixels.reset(pixels);
+		result.texels = pixels;
+		result.numLevels = 1;
+		if (!useCache)
+			return result;
+
+		// Make the mips here rather than with glGenerateMipmap, so the cache holds everything the upload needs
+		unsigned int numLevels = mipLevelCount(width, height);
+		result.chain.resize(mipChainSize(width, height, components, numLevels));
+		memcpy(result.chain.data(), pixels, mipLevelSize(width, height, components, 0));
+		unsigned char *level = result.chain.data();
+		for (unsigned int i = 1; i < numLevels; i++)
+		{
+			unsigned char *next = level + mipLevelSize(width, height, components, i - 1);
+			downsampleLevel(level, std::max(1, width >> (i - 1)), std::max(1, height >> (i - 1)), components, next);
+			level = next;
+		}
+		result.pixels.reset();
+		result.texels = result.chain.data();
+		result.numLevels = numLevels;
+
+		// If the cache can't be written the image just gets decoded again next launch
+		TextureCacheHeader header;
+		memcpy(header.magic, "TEXC", 4);
+		header.version = TEXTURE_CACHE_VERSION;
+		header.sourceHash = sourceHash;
+		header.width = width;
+		header.height = height;
+		header.components = components;
+		header.numLevels = numLevels;
+		saveTextureCache(cacheName, header, result.texels);
+		return result;
+	}
+
+	// Runs on the main thread. The texels are copied into a freshly orphaned pixel buffer, so glTexImage2D is
+	// sourced from buffer memory and returns without waiting on the copy to the GPU
+	void upload(const Decoded &image)
+	{
+		if (!image.texels)
+		{
+			std::cout << "Texture failed to load at path: " << image.fileName << std::endl;
+			return;
+		}
+
+		GLenum format = GL_RGBA;
+		if (image.components == 1)
+			format = GL_RED;
+		else if (image.components == 2)
+			format = GL_RG;
+		else if (image.components == 3)
+			format = GL_RGB;
+
+		size_t size = mipChainSize(image.width, image.height, image.components, image.numLevels);
+		const unsigned char *from = image.texels;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		void *staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (staging)
+		{
+			memcpy(staging, image.texels, size);
+			// The buffer contents are undefined if unmapping fails, so fall back on uploading from client memory
+			if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+				from = nullptr;
+		}
+		if (from)
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_2D, image.texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows aren't padded
+		size_t offset = 0;
+		for (unsigned int level = 0; level < image.numLevels; level++)
+		{
+			unsigned int width = std::max(1u, image.width >> level), height = std::max(1u, image.height >> level);
+			const void *texels = from ? (const void *)(from + offset) : (const void *)offset;
+			glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, texels);
+			offset += mipLevelSize(image.width, image.height, image.components, level);
+		}
+		if (image.numLevels == 1)
+			glGenerateMipmap(GL_TEXTURE_2D);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+};
+
+#endif
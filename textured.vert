@@ -1,24 +1,37 @@
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoord;
-
-out vec3 FragCoord;
-out vec3 Normal;
-out vec2 TexCoord;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-	//gl_Position = projection * view * model * vec4(aPos, 1.0);
-	//TexCoord = aTexCoord;
-
-	FragCoord = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
-    TexCoord = aTexCoord;
-    
-    gl_Position = projection * view * vec4(FragCoord, 1.0);
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+out vec3 FragCoord;
+out vec3 Normal;
+out vec2 TexCoord;
+
+uniform mat4 model;
+
+struct Light {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// Per frame values from one uniform buffer, see frame_uniforms.h. Must match in every shader that declares it
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    Light light;
+};
+
+void main()
+{
+	//gl_Position = projection * view * model * vec4(aPos, 1.0);
+	//TexCoord = aTexCoord;
+
+	FragCoord = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    TexCoord = aTexCoord;
+    
+    gl_Position = projection * view * vec4(FragCoord, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops
+// The calling thread also takes chunks, so a pool of 1 thread runs everything inline
+// One job runs at a time: a parallelFor called from inside another one's f runs inline on that thread
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int numThreads = 0)
+	{
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int i = 1; i < numThreads; i++)
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (unsigned int i = 0; i < workers.size(); i++)
+			workers[i].join();
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	unsigned int size() const { return workers.size() + 1; }
+
+	// Run f(begin, end) over [0, count) split into chunks of at most grain items and wait for all of them
+	void parallelFor(unsigned int count, unsigned int grain, const std::function<void(unsigned int, unsigned int)> &f)
+	{
+		if (count == 0)
+			return;
+		grain = std::max(1u, grain);
+		if (workers.empty() || count <= grain || insidePool())
+		{
+			f(0, count);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &f;
+			jobCount = count;
+			jobGrain = grain;
+			nextChunk = 0;
+			busyWorkers = workers.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		insidePool() = true;
+		runChunks(f, count, grain);
+		insidePool() = false;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return busyWorkers == 0; });
+		job = nullptr;
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	bool quit = false;
+	unsigned int generation = 0;
+	unsigned int busyWorkers = 0;
+
+	// Current job
+	const std::function<void(unsigned int, unsigned int)> *job = nullptr;
+	unsigned int jobCount = 0, jobGrain = 1;
+	std::atomic<unsigned int> nextChunk{ 0 };
+
+	// Set while this thread is running chunks of a job, so nested calls don't overwrite it
+	static bool &insidePool()
+	{
+		static thread_local bool inside = false;
+		return inside;
+	}
+
+	void runChunks(const std::function<void(unsigned int, unsigned int)> &f, unsigned int count, unsigned int grain)
+	{
+		while (true)
+		{
+			unsigned int begin = nextChunk.fetch_add(grain);
+			if (begin >= count)
+				break;
+			f(begin, std::min(count, begin + grain));
+		}
+	}
+
+	void workerLoop()
+	{
+		insidePool() = true;
+		unsigned int seen = 0;
+		while (true)
+		{
+			const std::function<void(unsigned int, unsigned int)> *f;
+			unsigned int count, grain;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return quit || generation != seen; });
+				if (quit)
+					return;
+				seen = generation;
+				f = job;
+				count = jobCount;
+				grain = jobGrain;
+			}
+
+			runChunks(*f, count, grain);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				busyWorkers--;
+			}
+			done.notify_one();
+		}
+	}
+};
+
+#endif
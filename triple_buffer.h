@@ -0,0 +1,42 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Single writer, single reader hand over of the latest value without locks
+// The writer fills back() and publishes it, the reader picks up whatever was published last. Neither ever waits for
+// the other: there are three slots, one owned by each side and one in the middle that publish and update swap with
+template<typename T>
+class TripleBuffer
+{
+public:
+	// Writer side, back() is only touched by the writer until it's published
+	T &back() { return slots[backIndex]; }
+
+	void publish()
+	{
+		backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader side, swap in the newest published value if there is one. Returns false if front() is unchanged
+	bool update()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & FRESH))
+			return false;
+		frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	// Stays valid and unchanged until the reader next calls update
+	const T &front() const { return slots[frontIndex]; }
+
+private:
+	enum : unsigned int { INDEX = 3, FRESH = 4 }; // middle holds a slot index plus whether it's unread
+
+	T slots[3];
+	unsigned int backIndex = 0;
+	unsigned int frontIndex = 1;
+	std::atomic<unsigned int> middle{ 2 };
+};
+
+#endif
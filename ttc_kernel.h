@@ -0,0 +1,259 @@
+#ifndef TTC_KERNEL_H
+#define TTC_KERNEL_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+#include "agent_store.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TTC_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TTC_SIMD_SSE2
+#endif
+
+// Time to collision avoidance force kernels
+// Each sums the force on one agent (px, pz, pvx, pvz) from agents [begin, end) of a store
+// The agent itself and agents that can't be reached within the horizon contribute exactly zero, so ranges don't
+// need to be filtered first
+
+struct TTCParams
+{
+	float agentRad;
+	float horizon;
+};
+
+// Avoidance force on an agent from one other agent
+inline glm::vec2 ttcForce(float px, float pz, float pvx, float pvz, float ox, float oz, float ovx, float ovz, const TTCParams &params)
+{
+	// First get tau
+	float tau;
+
+	float r = params.agentRad * 2.0f;
+	float wx = px - ox;
+	float wz = pz - oz;
+	float c = wx * wx + wz * wz - r * r;
+	if (c < 0)
+	{
+		tau = 0.0f;
+	}
+	else
+	{
+		float relVx = -pvx + ovx; //Reversed for some reason?
+		float relVz = -pvz + ovz;
+		float a = relVx * relVx + relVz * relVz;
+		float b = wx * relVx + wz * relVz;
+		float discr = b * b - a * c;
+		if (discr <= 0.0f)
+		{
+			tau = INFINITY;
+		}
+		else
+		{
+			tau = (b - sqrt(discr)) / a;
+			if (tau < 0) { tau = INFINITY; }
+		}
+	}
+	// Got tau
+
+	if (!(tau <= params.horizon))
+		return glm::vec2(0.0f);
+
+	float dirX = (px + pvx * tau) - (ox + ovx * tau);
+	float dirZ = (pz + pvz * tau) - (oz + ovz * tau);
+	if (dirX != 0.0f)
+	{
+		float len = sqrt(dirX * dirX + dirZ * dirZ);
+		dirX /= len;
+		dirZ /= len;
+	}
+
+	float mag = (params.horizon - tau) / (tau + 0.001f);
+	if (mag > 10.0f)
+		mag = 10.0f;
+
+	if (mag * dirX == mag * dirX)
+		return glm::vec2(mag * dirX, mag * dirZ);
+	return glm::vec2(0.0f);
+}
+
+inline glm::vec2 ttcForceSumScalar(const AgentStore &agents, unsigned int begin, unsigned int end,
+	float px, float pz, float pvx, float pvz, const TTCParams &params)
+{
+	glm::vec2 force(0.0f);
+	for (unsigned int o = begin; o < end; o++)
+		force = force + ttcForce(px, pz, pvx, pvz, agents.x[o], agents.z[o], agents.vx[o], agents.vz[o], params);
+	return force;
+}
+
+#if defined(TTC_SIMD_AVX2)
+
+// 8 pairs per iteration, lanes past end are masked off
+inline glm::vec2 ttcForceSumSimd(const AgentStore &agents, unsigned int begin, unsigned int end,
+	float px, float pz, float pvx, float pvz, const TTCParams &params)
+{
+	const float r = params.agentRad * 2.0f;
+	const __m256 r2 = _mm256_set1_ps(r * r);
+	const __m256 horizon = _mm256_set1_ps(params.horizon);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 inf = _mm256_set1_ps(INFINITY);
+	const __m256 maxMag = _mm256_set1_ps(10.0f);
+	const __m256 eps = _mm256_set1_ps(0.001f);
+	const __m256 vpx = _mm256_set1_ps(px), vpz = _mm256_set1_ps(pz);
+	const __m256 vpvx = _mm256_set1_ps(pvx), vpvz = _mm256_set1_ps(pvz);
+	const __m256i laneIds = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	__m256 fx = zero, fz = zero;
+	for (unsigned int k = begin; k < end; k += 8)
+	{
+		__m256i lanesLeft = _mm256_set1_epi32((int)(end - k));
+		__m256 inRange = _mm256_castsi256_ps(_mm256_cmpgt_epi32(lanesLeft, laneIds));
+
+		__m256 ox = _mm256_loadu_ps(agents.x + k);
+		__m256 oz = _mm256_loadu_ps(agents.z + k);
+		__m256 ovx = _mm256_loadu_ps(agents.vx + k);
+		__m256 ovz = _mm256_loadu_ps(agents.vz + k);
+
+		// tau
+		__m256 wx = _mm256_sub_ps(vpx, ox);
+		__m256 wz = _mm256_sub_ps(vpz, oz);
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(wx, wx), _mm256_mul_ps(wz, wz)), r2);
+		__m256 relVx = _mm256_sub_ps(ovx, vpvx);
+		__m256 relVz = _mm256_sub_ps(ovz, vpvz);
+		__m256 a = _mm256_add_ps(_mm256_mul_ps(relVx, relVx), _mm256_mul_ps(relVz, relVz));
+		__m256 b = _mm256_add_ps(_mm256_mul_ps(wx, relVx), _mm256_mul_ps(wz, relVz));
+		__m256 discr = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+
+		// Most pairs are overlapping-free and not closing in, skip the sqrt and divides if no lane can hit
+		__m256 approaching = _mm256_and_ps(_mm256_cmp_ps(discr, zero, _CMP_GT_OQ), _mm256_cmp_ps(b, zero, _CMP_GE_OQ));
+		__m256 mayHit = _mm256_and_ps(inRange, _mm256_or_ps(_mm256_cmp_ps(c, zero, _CMP_LT_OQ), approaching));
+		if (_mm256_movemask_ps(mayHit) == 0)
+			continue;
+
+		__m256 root = _mm256_div_ps(_mm256_sub_ps(b, _mm256_sqrt_ps(_mm256_max_ps(discr, zero))), a);
+		__m256 noHit = _mm256_or_ps(_mm256_cmp_ps(discr, zero, _CMP_LE_OQ), _mm256_cmp_ps(root, zero, _CMP_LT_OQ));
+		__m256 tau = _mm256_blendv_ps(root, inf, noHit);
+		tau = _mm256_blendv_ps(tau, zero, _mm256_cmp_ps(c, zero, _CMP_LT_OQ));
+
+		// Direction at closest approach, normalised only where x is non-zero (same as the scalar path)
+		__m256 dirX = _mm256_sub_ps(_mm256_add_ps(vpx, _mm256_mul_ps(vpvx, tau)), _mm256_add_ps(ox, _mm256_mul_ps(ovx, tau)));
+		__m256 dirZ = _mm256_sub_ps(_mm256_add_ps(vpz, _mm256_mul_ps(vpvz, tau)), _mm256_add_ps(oz, _mm256_mul_ps(ovz, tau)));
+		__m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dirX, dirX), _mm256_mul_ps(dirZ, dirZ)));
+		__m256 doNorm = _mm256_cmp_ps(dirX, zero, _CMP_NEQ_OQ);
+		dirX = _mm256_blendv_ps(dirX, _mm256_div_ps(dirX, len), doNorm);
+		dirZ = _mm256_blendv_ps(dirZ, _mm256_div_ps(dirZ, len), doNorm);
+
+		__m256 mag = _mm256_div_ps(_mm256_sub_ps(horizon, tau), _mm256_add_ps(tau, eps));
+		mag = _mm256_min_ps(mag, maxMag);
+
+		__m256 forceX = _mm256_mul_ps(mag, dirX);
+		__m256 forceZ = _mm256_mul_ps(mag, dirZ);
+		__m256 keep = _mm256_and_ps(inRange, _mm256_cmp_ps(tau, horizon, _CMP_LE_OQ));
+		keep = _mm256_and_ps(keep, _mm256_cmp_ps(forceX, forceX, _CMP_ORD_Q));
+		fx = _mm256_add_ps(fx, _mm256_and_ps(keep, forceX));
+		fz = _mm256_add_ps(fz, _mm256_and_ps(keep, forceZ));
+	}
+
+	float sx[8], sz[8];
+	_mm256_storeu_ps(sx, fx);
+	_mm256_storeu_ps(sz, fz);
+	glm::vec2 force(0.0f);
+	for (int i = 0; i < 8; i++)
+		force = force + glm::vec2(sx[i], sz[i]);
+	return force;
+}
+
+#elif defined(TTC_SIMD_SSE2)
+
+// SSE2 has no blend, so select with and/andnot
+inline __m128 ttcSelect(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// 4 pairs per iteration, lanes past end are masked off
+inline glm::vec2 ttcForceSumSimd(const AgentStore &agents, unsigned int begin, unsigned int end,
+	float px, float pz, float pvx, float pvz, const TTCParams &params)
+{
+	const float r = params.agentRad * 2.0f;
+	const __m128 r2 = _mm_set1_ps(r * r);
+	const __m128 horizon = _mm_set1_ps(params.horizon);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 inf = _mm_set1_ps(INFINITY);
+	const __m128 maxMag = _mm_set1_ps(10.0f);
+	const __m128 eps = _mm_set1_ps(0.001f);
+	const __m128 vpx = _mm_set1_ps(px), vpz = _mm_set1_ps(pz);
+	const __m128 vpvx = _mm_set1_ps(pvx), vpvz = _mm_set1_ps(pvz);
+	const __m128 laneIds = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+	__m128 fx = zero, fz = zero;
+	for (unsigned int k = begin; k < end; k += 4)
+	{
+		__m128 inRange = _mm_cmpgt_ps(_mm_set1_ps((float)(end - k)), laneIds);
+		__m128 ox = _mm_loadu_ps(agents.x + k), oz = _mm_loadu_ps(agents.z + k);
+		__m128 ovx = _mm_loadu_ps(agents.vx + k), ovz = _mm_loadu_ps(agents.vz + k);
+
+		// tau
+		__m128 wx = _mm_sub_ps(vpx, ox);
+		__m128 wz = _mm_sub_ps(vpz, oz);
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wz, wz)), r2);
+		__m128 relVx = _mm_sub_ps(ovx, vpvx);
+		__m128 relVz = _mm_sub_ps(ovz, vpvz);
+		__m128 a = _mm_add_ps(_mm_mul_ps(relVx, relVx), _mm_mul_ps(relVz, relVz));
+		__m128 b = _mm_add_ps(_mm_mul_ps(wx, relVx), _mm_mul_ps(wz, relVz));
+		__m128 discr = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+
+		// Most pairs are overlapping-free and not closing in, skip the sqrt and divides if no lane can hit
+		__m128 approaching = _mm_and_ps(_mm_cmpgt_ps(discr, zero), _mm_cmpge_ps(b, zero));
+		__m128 mayHit = _mm_and_ps(inRange, _mm_or_ps(_mm_cmplt_ps(c, zero), approaching));
+		if (_mm_movemask_ps(mayHit) == 0)
+			continue;
+
+		__m128 root = _mm_div_ps(_mm_sub_ps(b, _mm_sqrt_ps(_mm_max_ps(discr, zero))), a);
+		__m128 noHit = _mm_or_ps(_mm_cmple_ps(discr, zero), _mm_cmplt_ps(root, zero));
+		__m128 tau = ttcSelect(noHit, inf, root);
+		tau = ttcSelect(_mm_cmplt_ps(c, zero), zero, tau);
+
+		// Direction at closest approach, normalised only where x is non-zero (same as the scalar path)
+		__m128 dirX = _mm_sub_ps(_mm_add_ps(vpx, _mm_mul_ps(vpvx, tau)), _mm_add_ps(ox, _mm_mul_ps(ovx, tau)));
+		__m128 dirZ = _mm_sub_ps(_mm_add_ps(vpz, _mm_mul_ps(vpvz, tau)), _mm_add_ps(oz, _mm_mul_ps(ovz, tau)));
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dirX, dirX), _mm_mul_ps(dirZ, dirZ)));
+		__m128 doNorm = _mm_cmpneq_ps(dirX, zero);
+		dirX = ttcSelect(doNorm, _mm_div_ps(dirX, len), dirX);
+		dirZ = ttcSelect(doNorm, _mm_div_ps(dirZ, len), dirZ);
+
+		__m128 mag = _mm_div_ps(_mm_sub_ps(horizon, tau), _mm_add_ps(tau, eps));
+		mag = _mm_min_ps(mag, maxMag);
+
+		__m128 forceX = _mm_mul_ps(mag, dirX);
+		__m128 forceZ = _mm_mul_ps(mag, dirZ);
+		__m128 keep = _mm_and_ps(inRange, _mm_cmple_ps(tau, horizon));
+		keep = _mm_and_ps(keep, _mm_cmpord_ps(forceX, forceX));
+		fx = _mm_add_ps(fx, _mm_and_ps(keep, forceX));
+		fz = _mm_add_ps(fz, _mm_and_ps(keep, forceZ));
+	}
+
+	float sx[4], sz[4];
+	_mm_storeu_ps(sx, fx);
+	_mm_storeu_ps(sz, fz);
+	glm::vec2 force(0.0f);
+	for (int i = 0; i < 4; i++)
+		force = force + glm::vec2(sx[i], sz[i]);
+	return force;
+}
+
+#else
+
+// No SIMD on this target
+inline glm::vec2 ttcForceSumSimd(const AgentStore &agents, unsigned int begin, unsigned int end,
+	float px, float pz, float pvx, float pvz, const TTCParams &params)
+{
+	return ttcForceSumScalar(agents, begin, end, px, pz, pvx, pvz, params);
+}
+
+#endif
+
+#endif